@@ -0,0 +1,167 @@
+#ifndef ALG_AABB_TREE_HPP
+#define ALG_AABB_TREE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+
+namespace mw
+{
+inline namespace alg
+{
+
+/** @brief Axis-aligned bounding box. */
+struct aabb {
+  double xmin, ymin, xmax, ymax;
+
+  bool
+  overlaps(const aabb &other) const noexcept
+  {
+    return xmin <= other.xmax and other.xmin <= xmax and
+           ymin <= other.ymax and other.ymin <= ymax;
+  }
+
+  void
+  extend(const aabb &other) noexcept
+  {
+    xmin = std::min(xmin, other.xmin);
+    ymin = std::min(ymin, other.ymin);
+    xmax = std::max(xmax, other.xmax);
+    ymax = std::max(ymax, other.ymax);
+  }
+};
+
+
+/**
+ * @brief Static bounding volume hierarchy stored in a flat array.
+ *
+ * Nodes are laid out in depth-first order: the left child of an inner node
+ * immediately follows it, and the node stores the index of the right child.
+ * Items are referred to by their indices in the sequence of boxes passed to
+ * build().
+ */
+class aabb_tree {
+  public:
+  static constexpr uint32_t max_leaf_size = 4;
+
+  void
+  clear()
+  {
+    m_nodes.clear();
+    m_items.clear();
+    m_boxes.clear();
+  }
+
+  bool
+  empty() const noexcept
+  { return m_nodes.empty(); }
+
+  void
+  build(const std::vector<aabb> &boxes)
+  {
+    clear();
+    if (boxes.empty())
+      return;
+
+    m_items.resize(boxes.size());
+    for (uint32_t i = 0; i < boxes.size(); ++i)
+      m_items[i] = i;
+    m_nodes.reserve(2*boxes.size()/max_leaf_size + 1);
+    _build(boxes, 0, boxes.size());
+
+    // boxes of items in the order of leaves
+    m_boxes.reserve(boxes.size());
+    for (const uint32_t item : m_items)
+      m_boxes.push_back(boxes[item]);
+  }
+
+  /** @brief Call `yield(item)` for each item whose box overlaps @p box. */
+  template <typename Yield> void
+  query(const aabb &box, Yield&& yield) const
+  {
+    if (m_nodes.empty())
+      return;
+
+    uint32_t stack[64];
+    size_t sp = 0;
+    stack[sp++] = 0;
+    while (sp > 0)
+    {
+      const node &nd = m_nodes[stack[--sp]];
+      if (not nd.box.overlaps(box))
+        continue;
+
+      if (nd.count > 0)
+      {
+        for (uint32_t i = nd.first; i < nd.first + nd.count; ++i)
+        {
+          if (m_boxes[i].overlaps(box))
+            yield(m_items[i]);
+        }
+      }
+      else
+      {
+        const uint32_t self = &nd - m_nodes.data();
+        stack[sp++] = nd.first;
+        stack[sp++] = self + 1;
+      }
+    }
+  }
+
+  private:
+  struct node {
+    aabb box;
+    // leaf: range of m_items; inner node: index of the right child
+    uint32_t first;
+    uint32_t count;
+  };
+
+  uint32_t
+  _build(const std::vector<aabb> &boxes, uint32_t begin, uint32_t end)
+  {
+    const uint32_t self = m_nodes.size();
+    m_nodes.push_back({boxes[m_items[begin]], begin, end - begin});
+
+    constexpr double inf = std::numeric_limits<double>::infinity();
+    aabb centers = {+inf, +inf, -inf, -inf};
+    for (uint32_t i = begin; i < end; ++i)
+    {
+      const aabb &b = boxes[m_items[i]];
+      m_nodes[self].box.extend(b);
+      const double cx = (b.xmin + b.xmax)/2, cy = (b.ymin + b.ymax)/2;
+      centers.extend({cx, cy, cx, cy});
+    }
+
+    if (end - begin <= max_leaf_size)
+      return self;
+
+    // split by the median along the longest axis
+    const bool alongx =
+      centers.xmax - centers.xmin >= centers.ymax - centers.ymin;
+    const uint32_t mid = begin + (end - begin)/2;
+    std::nth_element(m_items.begin() + begin, m_items.begin() + mid,
+        m_items.begin() + end, [&] (uint32_t a, uint32_t b) {
+      const aabb &ba = boxes[a], &bb = boxes[b];
+      return alongx ? ba.xmin + ba.xmax < bb.xmin + bb.xmax
+                    : ba.ymin + ba.ymax < bb.ymin + bb.ymax;
+    });
+
+    m_nodes[self].count = 0;
+    _build(boxes, begin, mid);
+    const uint32_t right = _build(boxes, mid, end);
+    m_nodes[self].first = right;
+    return self;
+  }
+
+  std::vector<node> m_nodes;
+  std::vector<uint32_t> m_items;
+  std::vector<aabb> m_boxes;
+}; // class mw::alg::aabb_tree
+
+} // inline namespace mw::alg
+} // namespace mw
+
+#endif
@@ -9,8 +9,12 @@
 #include "common.hpp"
 #include "geometry.hpp"
 #include "object.hpp"
+#include "physics.hpp"
+#include "segment_table.hpp"
+#include "vision_service.hpp"
 #include "exceptions.hpp"
 #include "textures.hpp"
+#include "tile_cache.hpp"
 #include "video_manager.hpp"
 #include "canvas.hpp"
 #include "utl/grid.hpp"
@@ -25,6 +29,11 @@
 #include <tuple>
 #include <list>
 #include <optional>
+#include <vector>
+#include <algorithm>
+#include <memory>
+#include <unordered_map>
+#include <initializer_list>
 #include <boost/optional.hpp>
 
 
@@ -70,6 +79,8 @@ class area_map {
   private:
   enum oflag {
     is_static = 1 << 0,
+    // phys-obstacle is handled via the static segment table
+    is_indexed = 1 << 1,
   };
 
   public:
@@ -161,11 +172,7 @@ class area_map {
    */
   void
   set_view(const mapping &world_to_pixels) noexcept
-  {
-    m_x_offs = world_to_pixels.get_offset().x;
-    m_y_offs = world_to_pixels.get_offset().y;
-    m_scale = world_to_pixels.get_x_scale();
-  }
+  { _switch_view(world_to_pixels); }
 
   /** @brief Map a point in world to pixel position on a screen. */
   pt2d_i
@@ -243,6 +250,44 @@ class area_map {
   get_vis_obstacles() const noexcept
   { return m_vis_obstacles; }
 
+  /**
+   * @brief Get vis-obstacles residing in vicinity-grid cells overlapping a
+   * given circle.
+   *
+   * Each obstacle is listed once. Vis-obstacles which are not phys-obstacles
+   * can not be put on the grid and are always listed.
+   */
+  void
+  collect_vis_obstacles(const circle &circ,
+      vis_obstacle_list &out) const;
+
+  /**
+   * @brief Check whether no vis-obstacle blocks the line of sight between two
+   * points.
+   *
+   * Only obstacles on the vicinity grid around the segment are tested (see
+   * vis_obstacle::obscures()), and the test stops at the first one blocking
+   * the sight; this is much cheaper than processing full vision. Not
+   * thread-safe: a buffer of the map is reused.
+   *
+   * @param ignore Obstacles to be ignored, e.g. the observer and the target.
+   */
+  bool
+  has_line_of_sight(const pt2d_d &from, const pt2d_d &to,
+      std::initializer_list<const vis_obstacle*> ignore = {}) const;
+
+  /**
+   * @brief Check whether a circle is at least partly in the line of sight from
+   * a point.
+   *
+   * Lines of sight to the center of the circle and to both points where rays
+   * from @p from touch it are tested, so bodies sticking out from behind a
+   * corner are seen as well.
+   */
+  bool
+  has_line_of_sight(const pt2d_d &from, const circle &to,
+      std::initializer_list<const vis_obstacle*> ignore = {}) const;
+
   void
   adjust_offset(const pt2d_d &p, const pt2d_i &pix) noexcept;
 
@@ -252,8 +297,62 @@ class area_map {
   void
   adjust_to_box_h(const pt2d_i &at, int h) noexcept;
 
+  /** @name Physics
+   * @{ */
+  /**
+   * @brief Replace the physics processor.
+   *
+   * All registered phys-objects and phys-obstacles are handed over to the new
+   * processor.
+   */
+  void
+  set_physics(std::unique_ptr<physics_processor> physproc);
+
+  physics_processor&
+  get_physics() noexcept
+  { return *m_physics; }
+
+  const physics_processor&
+  get_physics() const noexcept
+  { return *m_physics; }
+
+  /**
+   * @brief Get line segments of static phys-obstacles.
+   *
+   * The table is built by build_grid(). Obstacles listed in it are not
+   * registered in the physics processor: the processor is expected to query
+   * the table instead.
+   */
+  const segment_table&
+  get_static_segments() const noexcept
+  { return m_static_segments; }
+  /** @} */
+
+  /**
+   * @brief Get the service processing vision requested by objects (see
+   * object::request_vision()) in the beginning of each tick.
+   */
+  vision_service&
+  get_vision_service() noexcept
+  { return m_vision_service; }
+
+  void
+  tick(int msec);
+
+  /**
+   * @brief Get the fraction of a physics step passed since the last tick.
+   *
+   * Phys-objects are drawn at their positions interpolated by this fraction
+   * (see phys_object::get_interpolated_position()). Defaults to 1, i.e. to
+   * the actual positions.
+   */
+  double
+  get_interpolation() const noexcept
+  { return m_interpolation; }
+
   void
-  tick(physics_processor &physproc, int msec);
+  set_interpolation(double alpha) noexcept
+  { m_interpolation = alpha; }
 
   /** @name Render map contents
    * @{ */
@@ -267,8 +366,29 @@ class area_map {
   draw_visible(const vision_processor &local_vision,
     const vision_processor &global_vision) const;
 
+  /** @brief Draw static phys-obstacles directly (bypassing cached tiles). */
   void
-  draw_obstacles() const;
+  draw_static_obstacles() const;
+
+  /**
+   * @brief Draw non-static phys-obstacles which are not phys-objects (e.g.
+   * doors).
+   */
+  void
+  draw_dynamic_obstacles() const;
+
+  /**
+   * @brief Draw a dot at the (interpolated) position of each phys-object
+   * which is also a phys-obstacle (characters), except for @p ignore.
+   */
+  void
+  draw_markers(int radius, color_t color,
+      const phys_object *ignore = nullptr) const;
+
+  /** @brief Get a number which changes whenever static objects change. */
+  size_t
+  get_static_version() const noexcept
+  { return m_static_version; }
 
   void
   draw_messages() const;
@@ -277,6 +397,12 @@ class area_map {
   void
   add_message(const std::string &msg);
 
+  /**
+   * @brief Draw a glow-texture over the background, shadowed by obstacles.
+   *
+   * With deferred lighting the glow is only recorded here, and all glows of
+   * the frame are drawn by draw_visible() or draw_all().
+   */
   void
   blit_glow_with_shadowcast(SDL_Texture *tex, const rectangle &dstbox,
       uint8_t alpha, int flags, vision_processor &visproc) const;
@@ -285,6 +411,23 @@ class area_map {
   blit_glow_with_shadowcast(SDL_Texture *tex, const rectangle &dstbox,
       uint8_t alpha, int flags) const;
 
+  /**
+   * @brief Gather glows of a frame and draw them in a single light-map pass.
+   *
+   * Glows are then accumulated in one screen-sized texture, and the
+   * background is composited with it once, instead of blitting it under each
+   * glow separately. If the light geometry fails to render, deferred
+   * lighting is turned off and glows are blitted separately.
+   */
+  void
+  set_deferred_lighting(bool enable) noexcept
+  { m_deferred_lighting = enable; }
+
+  /** @brief Set resolution of the light map relative to the screen. */
+  void
+  set_light_resolution(double fraction) noexcept
+  { m_light_resolution = std::clamp(fraction, 0.05, 1.); }
+
   void
   add_terrain_overlay(SDL_Texture *tex, const rectangle &dstbox, uint8_t alpha)
     const;
@@ -311,33 +454,162 @@ class area_map {
   eth::value
   dump() const;
 
+  /** @name Vicinity grid
+   * @{ */
+  /**
+   * @brief Re-populate dynamic part of the vicinity grid.
+   *
+   * Non-static phys-objects, phys-obstacles and vis-obstacles are put on the
+   * grid according to their current positions; entries from earlier updates
+   * are discarded.
+   */
+  void
+  update_vicinity_grid();
+
+  /**
+   * @brief Move a phys-object on the vicinity grid to its current position.
+   *
+   * Only the cells the object left or entered are touched, which is much
+   * cheaper than update_vicinity_grid() when only some of the objects have
+   * moved. Objects which are not on the dynamic part of the grid are
+   * ignored.
+   */
+  void
+  move_on_vicinity_grid(const phys_object *obj);
+
+  /**
+   * @brief Yield identifiers of objects residing in grid cells overlapping a
+   * given circle.
+   *
+   * Objects spanning several cells may be yielded more than once.
+   */
   template <typename Yield> void
   scan_vicinity(const circle &circ, Yield&& yield) const;
+  /** @} */
 
   private:
   void
   _put_on_vicinity_grid(const object_id &id, bool is_static);
 
+  /** @brief Put a non-static phys-object on cells covering its bounding box. */
+  void
+  _put_phys_object_on_vicinity_grid(const object_id &id);
+
+  void
+  _get_vicinity_cells(const phys_object *obj, size_t &ix0, size_t &iy0,
+      size_t &ix1, size_t &iy1) const noexcept;
+
+  void
+  _index_static_segments();
+
+  /**
+   * @brief Unregister and delete an object.
+   * @return Whether the static segments have to be re-indexed.
+   */
+  bool
+  _erase_object(object_iterator it);
+
+  void
+  _blit_glow(SDL_Texture *tex, const rectangle &dstbox, uint8_t alpha,
+      int flags, vision_processor &visproc) const;
+
+  /**
+   * @brief Draw static objects from cached tiles.
+   * @param frame Whether this is the main view of a new frame (tiles not used
+   * during the previous one are dropped).
+   */
+  void
+  _draw_static_tiles(bool frame) const;
+
+  void
+  _render_static_tile(SDL_Texture *tex, double scale, int ix, int iy) const;
+
+  /**
+   * @brief Set the viewport from a const method, for objects to draw
+   * themselves with a view of the caller (see _render_static_tile()).
+   * The caller must restore the view before returning.
+   */
+  void
+  _switch_view(const mapping &world_to_pixels) const noexcept
+  {
+    m_x_offs = world_to_pixels.get_offset().x;
+    m_y_offs = world_to_pixels.get_offset().y;
+    m_scale = world_to_pixels.get_x_scale();
+  }
+
+  /** @brief Draw glows recorded with deferred lighting. */
+  void
+  _draw_lights() const;
+
+  /**
+   * @brief Accumulate lit areas of the glows in a light map.
+   * @return False if the geometry could not be rendered.
+   */
+  bool
+  _add_lights(bool global, const mapping &map_to_light) const;
+
   private:
   sdl_environment &m_sdl;
   SDL_Texture *m_bgtex;
   mapping m_world_to_bgtex;
 
-  double m_scale;
-  double m_x_offs, m_y_offs;
+  // viewport; switched temporarily while drawing (see _switch_view())
+  mutable double m_scale;
+  mutable double m_x_offs, m_y_offs;
   double m_width, m_height;
   bool m_has_walls;
+  double m_interpolation;
 
   texture_storage &m_texstorage;
+  // canvases of blit_glow_with_shadowcast()
+  mutable render_target_pool m_render_targets;
+  // static objects pre-rendered at the current zoom (and that of the minimap)
+  mutable tile_cache m_static_tiles;
+  size_t m_static_version;
 
   std::list<object_entry> m_objects;
   std::list<phys_object*> m_phys_objects;
   std::list<phys_obstacle*> m_phys_obstacles;
   std::list<vis_obstacle*> m_vis_obstacles;
+  std::vector<const vis_obstacle*> m_off_grid_vis_obstacles;
+
+  // keeps track of registered phys-objects and phys-obstacles
+  std::unique_ptr<physics_processor> m_physics;
+  segment_table m_static_segments;
+  vision_service m_vision_service;
 
   boost::optional<grid<bool>> m_static_grid;
   utl::dynamic_grid<object_id> m_vicinity_grid;
+  // cells occupied by phys-objects since the last update of the grid
+  struct grid_footprint {
+    object_id id;
+    size_t ix0, iy0, ix1, iy1;
+    size_t stamp;
+  };
+  std::unordered_map<const phys_object*, grid_footprint> m_grid_footprints;
+  size_t m_grid_stamp;
   mutable boost::optional<const vision_processor&> m_global_vision;
+  // reused by blit_glow_with_shadowcast() between frames
+  mutable vision_processor m_glow_vision;
+  mutable vision_processor::sight_container m_glow_sights;
+  // reused by has_line_of_sight()
+  mutable vis_obstacle_list m_los_obstacles;
+
+  // deferred lighting
+  struct light {
+    SDL_Texture *tex;
+    rectangle box;
+    uint8_t alpha;
+    int flags;
+    const vis_obstacle *ignore;
+  };
+  // turned off when light geometry fails to render
+  mutable bool m_deferred_lighting;
+  double m_light_resolution;
+  mutable vision_vector<light> m_lights;
+  mutable vision_vector<SDL_Vertex> m_light_vertices;
+  mutable vision_vector<int> m_light_indices;
+  mutable vision_processor::sight_container m_lit_sights;
 
   message_log m_msglog;
 }; // class mw::area_map
@@ -360,10 +632,14 @@ mw::area_map::scan_vicinity(const circle &circ, Yield&& yield) const
   const double adjy = ch * std::round(circ.center.y / ch);
   const double adjr = circ.radius + std::max(cw, ch)/2;
 
-  const size_t ixstart = std::floor((adjx - adjr)/cw);
-  const size_t ixstop = std::floor((adjx + adjr)/cw);
-  const size_t iystart = std::floor((adjy - adjr)/ch);
-  const size_t iystop = std::floor((adjy + adjr)/ch);
+  // clamp to the grid (objects may get outside the map)
+  const auto cellidx = [] (double x, size_t n) -> size_t {
+    return x <= 0 ? 0 : x >= n ? n - 1 : size_t(x);
+  };
+  const size_t ixstart = cellidx(std::floor((adjx - adjr)/cw), nx);
+  const size_t ixstop = cellidx(std::floor((adjx + adjr)/cw), nx);
+  const size_t iystart = cellidx(std::floor((adjy - adjr)/ch), ny);
+  const size_t iystop = cellidx(std::floor((adjy + adjr)/ch), ny);
   for (size_t ix = ixstart; ix <= ixstop; ++ix)
   {
     for (size_t iy = iystart; iy <= iystop; ++iy)
@@ -3,6 +3,7 @@
 
 #include "object.hpp"
 #include "area_map.hpp"
+#include "physics.hpp"
 
 #include <SDL2/SDL.h>
 #include <SDL2/SDL2_gfxPrimitives.h>
@@ -37,39 +38,8 @@ class door: public phys_obstacle, public vis_obstacle {
   vec2d_d
   act_on_object(area_map &map, phys_object *subj) override
   {
-    vec2d_d force = {0, 0};
-
     const line_segment wall {m_door.origin, m_state * m_door.direction};
-
-    sight s;
-    const double r = subj->get_radius();
-    if (cast_sight({subj->get_position(), subj->get_radius()}, wall, s))
-    {
-      const double dphi = interval_size({s.phi1, s.phi2});
-      const double sector_area = r*r*dphi/2;
-      const double triang_area = r*r*sin(dphi/2)*cos(dphi/2);
-      const double overlap_area = sector_area - triang_area;
-      vec2d_d n = normalized(vec2d_d(-wall.direction.y, wall.direction.x));
-      n = n * copysign(1., dot(n, subj->get_position() - wall(s.sight_data.line.t1)));
-      force = force + overlap_area * n;
-
-      // special treatment for corners
-      double t1 = s.sight_data.line.t1;
-      double t2 = s.sight_data.line.t2;
-      if (t1 > t2)
-        std::swap(t1, t2);
-      if (t1 == 0)
-      {
-        const vec2d_d r = subj->get_position() - wall(t1);
-        force = force + normalized(r)*(subj->get_radius() - mag(r))/2;
-      }
-      if (t2 == 1)
-      {
-        const vec2d_d r = subj->get_position() - wall(t2);
-        force = force + normalized(r)*(subj->get_radius() - mag(r))/2;
-      }
-    }
-    return force;
+    return overlap_force({subj->get_position(), subj->get_radius()}, wall);
   }
 
   bool
@@ -85,6 +55,13 @@ class door: public phys_obstacle, public vis_obstacle {
   sample_point() const override
   { return m_door(1); }
 
+  bool
+  sweep(const tunnel &path, double &t, vec2d_d &n) const override
+  {
+    const line_segment wall {m_door.origin, m_state * m_door.direction};
+    return sweep_tunnel_linesegm(path, wall, t, n);
+  }
+
   void
   draw(const area_map &map) const override
   {
@@ -102,6 +79,14 @@ class door: public phys_obstacle, public vis_obstacle {
       visproc.add_sight(s, 0);
   }
 
+  bool
+  obscures(const line_segment &ray) const override
+  {
+    const line_segment visiblepart {m_door.origin, m_state * m_door.direction};
+    double t1, t2;
+    return intersect(ray, visiblepart, t1, t2) == 1;
+  }
+
   void
   draw(const area_map &map, const sight &s) const override
   {
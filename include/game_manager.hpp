@@ -2,11 +2,12 @@
 #define GAME_MANAGER_HPP
 
 #include "area_map.hpp"
+#include "physics.hpp"
 #include "sdl_environment.hpp"
 #include "player.hpp"
 #include "ui_layer.hpp"
 #include "hud.hpp"
-#include "utl/frequency_limiter.hpp"
+#include "vision_cache.hpp"
 #include "controls/controller.hpp"
 
 #include <SDL2/SDL.h>
@@ -22,9 +23,22 @@ class game_manager: public ui_layer {
   : ui_layer(ui_layer::size::whole_screen),
     m_sdl {sdl},
     m_map {map},
-    m_tick_limiter {std::chrono::milliseconds {10}},
-    m_input {input}
-  { }
+    m_tick_size {10},
+    m_max_catchup_ticks {5},
+    m_tick_accumulator {0},
+    m_input {input},
+    m_minimap_period {100}
+  {
+    auto physproc = std::make_unique<md_physics>();
+    physproc->set_worker_pool(&worker_pool::instance());
+    m_map.set_physics(std::move(physproc));
+    m_map.get_vision_service().set_worker_pool(&worker_pool::instance());
+    m_local_vision.set_engine(vision_engine::angular_sweep);
+    m_local_vision.set_incremental(true);
+    m_map.set_deferred_lighting(true);
+  }
+
+  ~game_manager();
 
   void
   set_player(player &p, double vision_radius) noexcept
@@ -33,6 +47,45 @@ class game_manager: public ui_layer {
     m_player_vision_radius = vision_radius;
   }
 
+  /**
+   * @brief Set the duration of a physics step [msec].
+   *
+   * Game time is advanced in steps of exactly this size, however long the
+   * frames take. Non-positive values are clamped to 1 msec.
+   */
+  void
+  set_tick_size(int msec) noexcept
+  { m_tick_size = std::max(msec, 1); }
+
+  /**
+   * @brief Limit the number of physics steps made within a single frame.
+   *
+   * If the game falls further behind, the remaining time is dropped (i.e. the
+   * game slows down instead of spending ever more time catching up).
+   */
+  void
+  set_max_catchup_ticks(int n) noexcept
+  { m_max_catchup_ticks = n; }
+
+  /**
+   * @brief Set how far the player may move before the global vision (used to
+   * draw the fog of war) is recomputed.
+   */
+  void
+  set_global_vision_epsilon(double eps) noexcept
+  { m_global_vision.set_epsilon(eps); }
+
+  /**
+   * @brief Set how often the minimap is redrawn [msec].
+   *
+   * Static obstacles are kept pre-rendered in the minimap and are only
+   * redrawn when they change; moving obstacles are updated with this period.
+   * Markers of objects are drawn over the minimap every frame.
+   */
+  void
+  set_minimap_period(time_t msec) noexcept
+  { m_minimap_period = msec; }
+
   heads_up_display&
   hud() noexcept
   { return m_hud; }
@@ -59,6 +112,9 @@ class game_manager: public ui_layer {
   void
   _handle_zoom_keys(const pt2d_i &at, time_t dt);
 
+  void
+  _draw_minimap() const;
+
   void
   _handle_map_movement_keys(time_t dt);
 
@@ -68,7 +124,10 @@ class game_manager: public ui_layer {
   boost::optional<player&> m_player;
   double m_player_vision_radius;
   std::optional<time_t> m_prev_time;
-  frequency_limiter m_tick_limiter;
+  // fixed-step simulation [msec]
+  int m_tick_size;
+  int m_max_catchup_ticks;
+  time_t m_tick_accumulator;
 
   bool m_center_on_player = true;
   bool m_fow_enabled = true;
@@ -77,6 +136,16 @@ class game_manager: public ui_layer {
 
   heads_up_display m_hud;
   mutable hud_footprint m_hud_footprint;
+  mutable vision_processor m_local_vision;
+  mutable vision_cache m_global_vision;
+
+  // minimap: static obstacles, and the whole of it as last redrawn
+  time_t m_minimap_period;
+  mutable SDL_Texture *m_minimap_static = nullptr;
+  mutable SDL_Texture *m_minimap = nullptr;
+  mutable int m_minimap_w = 0, m_minimap_h = 0;
+  mutable std::optional<size_t> m_minimap_version;
+  mutable std::optional<uint32_t> m_minimap_time;
 }; // class game_manager
 
 } // namespace mw
@@ -395,6 +395,21 @@ intersect(const tunnel &p, const line_segment &l, double &t, ignore_ends);
 int
 intersect(const line_segment &l, const circle &c, double &t);
 
+/**
+ * @brief Find the first contact of a circle moving along a tunnel with a line
+ * segment.
+ * @param p Tunnel swept by the circle.
+ * @param l Line segment.
+ * @param[out] t Time point of the contact within [0, 1].
+ * @param[out] n Normal of the contact (pointing from the segment towards the
+ * circle); not normalized.
+ * @return Whether the circle hits the segment. Contacts of a circle already
+ * overlapping the segment at `t=0` are not reported.
+ */
+bool
+sweep_tunnel_linesegm(const tunnel &p, const line_segment &l, double &t,
+    vec2d_d &n);
+
 bool
 overlap_box_circle(const rectangle &r, const circle &c);
 
@@ -3,6 +3,7 @@
 
 #include "geometry.hpp"
 #include "vision.hpp"
+#include "vision_service.hpp"
 #include "ai/exploration.hpp"
 
 #include <optional>
@@ -24,6 +25,11 @@ struct mind {
 
   virtual void
   update(const area_map &map, int n_ticks_passed) = 0;
+
+  /** @brief See object::request_vision(). */
+  virtual void
+  request_vision(const area_map &map, vision_service &service,
+      int n_ticks_passed) { }
 }; // class mw::mind
 
 
@@ -37,6 +43,10 @@ class simple_ai: public mind {
   void
   update(const area_map &map, int n_ticks_passed) override;
 
+  void
+  request_vision(const area_map &map, vision_service &service,
+      int n_ticks_passed) override;
+
   const explorer&
   get_explorer() const noexcept
   { return m_exploration.explr; }
@@ -50,9 +60,18 @@ class simple_ai: public mind {
   { return m_do_chase_player; }
 
   private:
+  /** @brief Check whether the player is in sight. */
   void
   sync_vision(const area_map &map);
 
+  /** @brief Process full vision (used for exploration). */
+  void
+  process_vision(const area_map &map);
+
+  bool
+  is_exploration_due(time_t now) const noexcept
+  { return now - m_exploration.timestamp > 10; }
+
   void
   sync_path(const area_map &map);
 
@@ -70,10 +89,14 @@ class simple_ai: public mind {
   time_t m_current_time;
 
   struct vision_data {
-    vision_data(): timestamp {0} { }
+    vision_data(): timestamp {0}, is_requested {false} { }
     vision_processor visproc;
     std::optional<const player*> visible_player;
+    // reused to look for the player
+    vis_obstacle_list obstacles;
     time_t timestamp;
+    // visproc is processed by the vision service
+    bool is_requested;
   } m_vision;
 
   struct path_data {
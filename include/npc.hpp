@@ -73,6 +73,11 @@ class npc: public phys_object, public vis_obstacle, public safe_access<npc> {
   void
   receive_hit(area_map &map, const hit &hit) override;
 
+  void
+  request_vision(const area_map &map, vision_service &service,
+      int n_ticks_passed) override
+  { m_mind->request_vision(map, service, n_ticks_passed); }
+
   bool
   is_gone() const override
   { return m_body->is_dead(); }
@@ -80,6 +85,9 @@ class npc: public phys_object, public vis_obstacle, public safe_access<npc> {
   void
   get_sights(vision_processor &visproc) const override;
 
+  bool
+  obscures(const line_segment &ray) const override;
+
   void
   draw(const area_map &map, const sight &s) const override;
 
@@ -9,6 +9,7 @@
 #include "geometry.hpp"
 #include "vision.hpp"
 #include "hit.hpp"
+#include "phys_state_store.hpp"
 
 #include <ether/ether.hpp>
 
@@ -17,6 +18,7 @@ namespace mw {
 
 class area_map;
 class vision_processor;
+class vision_service;
 class physics_processor;
 
 
@@ -32,6 +34,16 @@ struct object {
   virtual void
   receive_hit(area_map &, const hit &hit) { };
 
+  /**
+   * @brief Queue vision needed by the next update().
+   *
+   * Called every tick before objects are updated, with the same
+   * @p n_ticks_passed as that update(); requests of all objects are then
+   * processed together. Default implementation requests nothing.
+   */
+  virtual void
+  request_vision(const area_map&, vision_service&, int n_ticks_passed) { }
+
   virtual bool
   is_gone() const = 0;
 
@@ -54,6 +66,33 @@ struct phys_obstacle: public virtual object {
 
   virtual pt2d_d
   sample_point() const = 0;
+
+  /**
+   * @brief Find the first contact of a circle moving along @p path with this
+   * obstacle (continuous collision detection).
+   *
+   * @param[out] t Time point of the contact within [0, 1].
+   * @param[out] n Normal of the contact pointing towards the circle.
+   *
+   * Default implementation reports no contacts.
+   */
+  virtual bool
+  sweep(const tunnel &path, double &t, vec2d_d &n) const
+  { return false; }
+
+  /**
+   * @brief Describe the obstacle as a set of rigid line segments.
+   *
+   * Static obstacles doing so are indexed by the area map and handled by the
+   * physics processor as plain walls: act_on_object() and sweep() are no
+   * longer called for them. Thus, return true only if these methods evaluate
+   * exactly the wall force (see overlap_force()) and sweep over the segments.
+   *
+   * Default implementation returns false.
+   */
+  virtual bool
+  get_segments(std::vector<line_segment> &segs) const
+  { return false; }
 }; // struct mw::phys_obstacle
 
 
@@ -64,8 +103,12 @@ class phys_object: public phys_obstacle {
     m_mass {80},
     m_friction_coeff {0.8},
     m_position {position},
+    m_prev_position {position},
     m_velocity {0, 0},
-    m_internal_acceleration {0, 0}
+    m_internal_acceleration {0, 0},
+    m_phys_handle {no_phys_handle},
+    m_idle_ticks {0},
+    m_sleeping {false}
   { }
 
   virtual
@@ -77,10 +120,30 @@ class phys_object: public phys_obstacle {
   const pt2d_d&  get_position() const noexcept { return m_position; }
   const vec2d_d& get_velocity() const noexcept { return m_velocity; }
   const vec2d_d& get_internal_acceleration() const noexcept { return m_internal_acceleration; }
+  phys_handle    get_phys_handle() const noexcept { return m_phys_handle; }
+
+  /**
+   * @brief Get position interpolated between the start (@p alpha = 0) and
+   * the end (@p alpha = 1) of the last physics step.
+   */
+  pt2d_d
+  get_interpolated_position(double alpha) const noexcept
+  { return m_prev_position + (m_position - m_prev_position)*alpha; }
+
+  /** @brief Mark current position as the start of a physics step. */
+  void           begin_step() noexcept { m_prev_position = m_position; }
 
   void           set_mass(double m) noexcept { m_mass = m; }
   void           set_friction_coeff(double k) noexcept { m_friction_coeff = k; }
 
+  /** @name Sleeping
+   * Objects resting for a while are skipped by physics until something
+   * disturbs them.
+   * @{ */
+  bool           is_sleeping() const noexcept { return m_sleeping; }
+  void           wake_up() noexcept { m_sleeping = false; m_idle_ticks = 0; }
+  /** @} */
+
   virtual vec2d_d
   act_on_object(area_map &map, phys_object *subj) override;
 
@@ -97,8 +160,16 @@ class phys_object: public phys_obstacle {
 
   protected:
   void set_position(const pt2d_d &p) noexcept { m_position = p; }
-  void set_velocity(const vec2d_d &v) noexcept { m_velocity = v; }
-  void set_internal_acceleration(const vec2d_d &a) noexcept { m_internal_acceleration = a; }
+  void set_velocity(const vec2d_d &v) noexcept { m_velocity = v; _wake_if_moved(v); }
+  void set_internal_acceleration(const vec2d_d &a) noexcept { m_internal_acceleration = a; _wake_if_moved(a); }
+
+  private:
+  void
+  _wake_if_moved(const vec2d_d &x) noexcept
+  {
+    if (x.x != 0 or x.y != 0)
+      wake_up();
+  }
 
   private:
   // shape
@@ -108,10 +179,17 @@ class phys_object: public phys_obstacle {
   double m_friction_coeff;
   // state
   pt2d_d m_position;
+  pt2d_d m_prev_position;
   vec2d_d m_velocity;
   vec2d_d m_internal_acceleration;
+  // index in the state store of a physics processor
+  phys_handle m_phys_handle;
+  // sleeping
+  int m_idle_ticks;
+  bool m_sleeping;
 
   friend class physics_processor;
+  friend class phys_state_store;
 }; // struct mw::phys_object
 
 
@@ -126,6 +204,37 @@ class vis_obstacle: public virtual object {
 
   virtual void
   draw(const area_map&, const sight&) const = 0;
+
+  /**
+   * @brief Whether the obstacle never moves nor changes its shape, so that
+   * its sights may be cached.
+   *
+   * Default implementation returns false.
+   */
+  virtual bool
+  is_immutable() const
+  { return false; }
+
+  /**
+   * @brief Check whether the obstacle blocks the line of sight along @p ray.
+   *
+   * Must agree with get_sights(). Default implementation returns false.
+   */
+  virtual bool
+  obscures(const line_segment &ray) const
+  { return false; }
+
+  /**
+   * @brief Get line segments if sights of the obstacle are exactly the ones
+   * added by vision_processor::add_line_sights() for them.
+   *
+   * Segments of such obstacles are cast in a single batch by
+   * vision_processor::load_obstacles(). Default implementation returns
+   * nullptr.
+   */
+  virtual const segment_batch*
+  get_sight_segments() const
+  { return nullptr; }
 }; // struct mw::vis_obstacle
 
 
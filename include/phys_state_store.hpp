@@ -0,0 +1,129 @@
+/**
+ * @file phys_state_store.hpp
+ * @brief Contiguous storage for dynamical state of phys-objects
+ */
+#ifndef PHYS_STATE_STORE_HPP
+#define PHYS_STATE_STORE_HPP
+
+#include "geometry.hpp"
+
+#include <vector>
+#include <limits>
+
+
+namespace mw {
+
+class phys_object;
+
+/** @brief Index of a phys-object within a @ref phys_state_store. */
+typedef size_t phys_handle;
+
+/** @brief Handle of an object not attached to any store. */
+constexpr phys_handle no_phys_handle = std::numeric_limits<phys_handle>::max();
+
+/**
+ * @brief Dynamical state of phys-objects laid out as a structure of arrays.
+ *
+ * Every field is kept in a separate contiguous array so that integration and
+ * velocity-dependent forces can be evaluated with vectorized kernels over all
+ * objects at once.
+ */
+class phys_state_store {
+  public:
+  void
+  clear() noexcept;
+
+  size_t
+  size() const noexcept
+  { return m_objects.size(); }
+
+  /** @brief Append an object; returns its handle. */
+  phys_handle
+  add(phys_object *obj);
+
+  /**
+   * @brief Remove an object; the last object takes its place (and its
+   * handle).
+   */
+  void
+  remove(phys_handle h) noexcept;
+
+  /** @brief Copy state of all objects into the store. */
+  void
+  gather();
+
+  /** @brief Copy position and velocity of an object back to it. */
+  void
+  scatter(phys_handle h) const noexcept;
+
+  phys_object*
+  get_object(phys_handle h) const noexcept
+  { return m_objects[h]; }
+
+  /** @brief Check whether the object is attached to this store. */
+  bool
+  contains(const phys_object *obj) const noexcept;
+
+  pt2d_d
+  get_position(phys_handle h) const noexcept
+  { return {m_px[h], m_py[h]}; }
+
+  /** @brief Position before the last call to integrate(). */
+  pt2d_d
+  get_previous_position(phys_handle h) const noexcept
+  { return {m_px0[h], m_py0[h]}; }
+
+  vec2d_d
+  get_velocity(phys_handle h) const noexcept
+  { return {m_vx[h], m_vy[h]}; }
+
+  void
+  set_position(phys_handle h, const pt2d_d &p) noexcept
+  { m_px[h] = p.x; m_py[h] = p.y; }
+
+  void
+  set_velocity(phys_handle h, const vec2d_d &v) noexcept
+  { m_vx[h] = v.x; m_vy[h] = v.y; }
+
+  /** @brief Net force evaluated for the last step of the object. */
+  vec2d_d
+  get_force(phys_handle h) const noexcept
+  { return {m_fx[h], m_fy[h]}; }
+
+  /** @brief Add a force acting on the object. */
+  void
+  add_force(phys_handle h, const vec2d_d &f) noexcept
+  { m_fx[h] += f.x; m_fy[h] += f.y; }
+
+  /**
+   * @brief Reset forces to the own forces of objects: internal acceleration
+   * times mass minus friction.
+   */
+  void
+  reset_forces() noexcept;
+
+  /**
+   * @brief Advance positions and velocities by per-object time steps.
+   *
+   * Objects with zero time step are left intact.
+   */
+  void
+  integrate(const std::vector<double> &dt) noexcept;
+
+  private:
+  std::vector<phys_object*> m_objects;
+  // state
+  std::vector<double> m_px, m_py;
+  std::vector<double> m_px0, m_py0;
+  std::vector<double> m_vx, m_vy;
+  std::vector<double> m_ax, m_ay;
+  // physical properties
+  std::vector<double> m_mass;
+  std::vector<double> m_friction;
+  // accumulated forces
+  std::vector<double> m_fx, m_fy;
+}; // class mw::phys_state_store
+
+} // namespace mw
+
+#endif
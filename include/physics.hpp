@@ -2,6 +2,11 @@
 #define PHYSICS_HPP
 
 #include "object.hpp"
+#include "phys_state_store.hpp"
+#include "segment_table.hpp"
+#include "utl/worker_pool.hpp"
+
+#include <unordered_map>
 
 namespace mw {
 
@@ -20,11 +25,67 @@ pushing(double m1, const pt2d_d &o1, vec2d_d &a1,
         double m2, const pt2d_d &o2, vec2d_d &a2);
 
 
+/**
+ * @brief Force exerted by a rigid wall on a circle overlapping it.
+ *
+ * The force is proportional to the area of the circle cut off by the wall and
+ * is directed along the wall normal, with extra push-out from wall ends.
+ */
+vec2d_d
+overlap_force(const circle &c, const line_segment &wall);
+
+/** @brief Sum of forces exerted by a batch of walls on a circle. */
+vec2d_d
+overlap_force(const circle &c, const segment_batch &walls);
+
+
+/** @brief Collision of a phys-object with an obstacle. */
+struct collision_event {
+  phys_object *obj;
+  phys_obstacle *obs;
+  // force exerted by OBJ on OBS along with the collision (if OBS is a
+  // phys-object whose forces were being evaluated)
+  vec2d_d force = {0, 0};
+};
+
+typedef std::vector<collision_event> collision_buffer;
+
+/**
+ * @brief Let @p obj know it collided with @p obs.
+ *
+ * Calls phys_object::on_collision() right away unless a @ref
+ * collision_buffer_scope is active in the calling thread, in which case the
+ * event is only recorded.
+ */
+void
+report_collision(area_map &map, phys_object *obj, phys_obstacle *obs);
+
+/**
+ * @brief Record collisions reported by the current thread into a buffer
+ * while the scope is alive.
+ */
+class collision_buffer_scope {
+  public:
+  collision_buffer_scope(collision_buffer &buf) noexcept;
+  ~collision_buffer_scope();
+
+  collision_buffer_scope(const collision_buffer_scope&) = delete;
+  collision_buffer_scope& operator = (const collision_buffer_scope&) = delete;
+
+  private:
+  collision_buffer *m_prev;
+};
+
+
 class physics_processor {
   public:
+  virtual ~physics_processor() = default;
+
   virtual void add_object(phys_object *obj) = 0;
   virtual void add_obstacle(phys_obstacle *obs) = 0;
-  virtual void process(area_map &map) = 0;
+  virtual void remove_object(phys_object *obj) = 0;
+  virtual void remove_obstacle(phys_obstacle *obs) = 0;
+  virtual void process(area_map &map, double tick_size) = 0;
 
   protected:
   void
@@ -34,41 +95,213 @@ class physics_processor {
   void
   set_velocity(phys_object *obj, const vec2d_d &v) const noexcept
   { obj->set_velocity(v); }
+
+  int
+  get_idle_ticks(const phys_object *obj) const noexcept
+  { return obj->m_idle_ticks; }
+
+  void
+  set_idle_ticks(phys_object *obj, int n) const noexcept
+  { obj->m_idle_ticks = n; }
+
+  void
+  put_to_sleep(phys_object *obj) const noexcept
+  {
+    obj->m_sleeping = true;
+    obj->m_velocity = {0, 0};
+  }
+};
+
+
+/**
+ * @brief Strategy for selecting pairs of interacting objects.
+ *
+ * - brute_force: every object is tested against every obstacle and every
+ *   other object;
+ * - vicinity_grid: only objects and obstacles sharing a cell of the
+ *   vicinity grid of the area map are tested.
+ */
+enum class broad_phase {
+  brute_force,
+  vicinity_grid,
+};
+
+
+/**
+ * @brief Substepping chosen by @ref md_physics for a tick.
+ *
+ * Objects are split into rate classes: objects of class k are integrated
+ * every 2^k substeps with a step of 2^k substep sizes.
+ */
+struct step_schedule {
+  int n_substeps;
+  double substep_size;
+  std::vector<size_t> class_sizes;
 };
 
 
 // TODO: rename
 class md_physics: public physics_processor {
   public:
-  md_physics(double tick_size = 1)
-  : m_tick_size {tick_size}
+  explicit
+  md_physics(broad_phase broadphase = broad_phase::vicinity_grid)
+  : m_tick_size {0},
+    m_broad_phase {broadphase},
+    m_workers {nullptr},
+    m_courant {0.5},
+    m_max_substeps {16},
+    m_schedule {1, 0, {}},
+    m_sleep_velocity {1e-4},
+    m_sleep_acceleration {1e-6},
+    m_sleep_ticks {30}
   { }
 
   void
-  add_object(phys_object *obj) noexcept override
-  { m_objects.push_back(obj); }
+  add_object(phys_object *obj) override
+  {
+    m_objects.push_back(obj);
+    m_state.add(obj);
+  }
+
+  void
+  add_obstacle(phys_obstacle *obs) override
+  {
+    m_obstacle_index.emplace(obs, m_obstacles.size());
+    m_obstacles.push_back(obs);
+  }
+
+  void
+  remove_object(phys_object *obj) override;
+
+  void
+  remove_obstacle(phys_obstacle *obs) override;
+
+  void
+  process(area_map &map, double tick_size) override;
 
+  /**
+   * @brief Evaluate forces on the given pool of threads; pass nullptr to run
+   * on the calling thread only.
+   *
+   * Results are bit-identical in either mode: collisions are dispatched after
+   * force evaluation, in the order of objects. The outcome is the same as if
+   * they were dispatched right away: an object made gone by a collision does
+   * not act on objects following in this order, and is not moved.
+   */
   void
-  add_obstacle(phys_obstacle *obs) noexcept override
-  { m_obstacles.push_back(obs); }
+  set_worker_pool(worker_pool *pool) noexcept
+  { m_workers = pool; }
 
+  /**
+   * @brief Set the fraction of a radius an object may travel in one step.
+   *
+   * Substeps are chosen so that for every object of non-zero radius, `v*dt`
+   * and `a*dt*dt/2` stay below this fraction of the smallest radius among the
+   * object and its neighbours. Besides, `dt` stays below `sqrt(m/k)`, where
+   * `k` bounds the stiffness of contact forces acting on the object, so that
+   * penalty contacts do not overshoot. Point-like objects rely on continuous
+   * collision detection instead.
+   */
   void
-  process(area_map &map) override;
+  set_courant_number(double c) noexcept
+  { m_courant = c; }
+
+  /** @brief Limit the number of substeps per tick (rounded to a power of 2). */
+  void
+  set_max_substeps(int n) noexcept
+  { m_max_substeps = n; }
+
+  /**
+   * @brief Set when objects fall asleep.
+   *
+   * An object is idle within a tick if its speed and the acceleration due to
+   * the net force are below given thresholds. A contact island (a group of
+   * touching objects) falls asleep when all its objects stayed idle for
+   * @p nticks consecutive ticks. Sleeping objects are woken by contacts with
+   * awake objects, by hits, and by internal acceleration; the whole island
+   * wakes with them.
+   */
+  void
+  set_sleep_thresholds(double velocity, double acceleration, int nticks)
+    noexcept
+  {
+    m_sleep_velocity = velocity;
+    m_sleep_acceleration = acceleration;
+    m_sleep_ticks = nticks;
+  }
+
+  /** @brief Get the substepping used for the last processed tick. */
+  const step_schedule&
+  get_step_schedule() const noexcept
+  { return m_schedule; }
 
   private:
-  typedef std::pair<mw::phys_object*, mw::vec2d_d> obj_dynamics;
+  void
+  _plan_substeps(const area_map &map);
+
+  void
+  _schedule_substep(int substep);
+
+  void
+  _collect_neighbours(const area_map &map, const circle &reach,
+      std::vector<phys_obstacle*> &obstacles,
+      std::vector<phys_object*> &objects) const;
+
+  void
+  _calc_dynamics(area_map &map);
+
+  void
+  _sweep_fast_objects(area_map &map);
+
+  void
+  _dispatch_collisions(area_map &map);
+
+  void
+  _apply_impact(area_map &map, phys_object *obj, phys_object *obj2, double t,
+      collision_buffer &ignored);
+
+  vec2d_d
+  _sum_forces(area_map &map, phys_object *obj,
+      const std::vector<phys_obstacle*> &obstacles,
+      const std::vector<phys_object*> &objects, collision_buffer &collisions);
+
+  void
+  _advance_objects(area_map &map);
+
+  template <typename Yield> void
+  _scan_contacts(const area_map &map, const phys_object *obj, Yield&& yield);
 
   void
-  _calc_dynamics(area_map &map, std::vector<obj_dynamics> &dyn) const;
+  _wake_touched(area_map &map);
 
   void
-  _advance_objects(area_map &map, double dt,
-      const std::vector<obj_dynamics> &dyn);
+  _update_sleep_states(area_map &map);
 
   private:
-  const double m_tick_size;
+  double m_tick_size;
+  const broad_phase m_broad_phase;
+  // i'th object has handle i in m_state
   std::vector<phys_object*> m_objects;
   std::vector<phys_obstacle*> m_obstacles;
+  std::unordered_map<const phys_obstacle*, size_t> m_obstacle_index;
+  // positions, velocities and forces of m_objects
+  phys_state_store m_state;
+  worker_pool *m_workers;
+  // deferred collisions: one buffer per chunk of m_objects, and the last one
+  // for continuous collision detection
+  std::vector<collision_buffer> m_collisions;
+  // substepping
+  double m_courant;
+  int m_max_substeps;
+  step_schedule m_schedule;
+  std::vector<uint8_t> m_rate_class;
+  // time step of each object for the current substep (zero if skipped)
+  std::vector<double> m_dt;
+  // sleeping
+  std::vector<bool> m_restless;
+  double m_sleep_velocity;
+  double m_sleep_acceleration;
+  int m_sleep_ticks;
 }; // class mw::md_physics
 
 
@@ -54,6 +54,9 @@ class player: public phys_object, public vis_obstacle {
   void
   get_sights(vision_processor &visproc) const override;
 
+  bool
+  obscures(const line_segment &ray) const override;
+
   void
   draw(const area_map &map, const sight &s) const override;
 
@@ -69,6 +72,8 @@ class player: public phys_object, public vis_obstacle {
   double m_speed;
   SDL_Texture *m_glowtex;
   double m_glowradius;
+  // kept between frames to reuse its buffers
+  mutable vision_processor m_glow_vision;
   std::unordered_map<ability_slot, ability*> m_abilities;
 }; // class mw::player
 
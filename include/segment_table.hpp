@@ -0,0 +1,106 @@
+/**
+ * @file segment_table.hpp
+ * @brief Spatial index of line segments of static obstacles
+ */
+#ifndef SEGMENT_TABLE_HPP
+#define SEGMENT_TABLE_HPP
+
+#include "geometry.hpp"
+#include "algorithms/aabb_tree.hpp"
+
+#include <vector>
+#include <cstdint>
+
+
+namespace mw {
+
+struct phys_obstacle;
+
+/** @brief Line segments laid out as a structure of arrays. */
+struct segment_batch {
+  // origins
+  std::vector<double> ox, oy;
+  // directions
+  std::vector<double> dx, dy;
+
+  size_t
+  size() const noexcept
+  { return ox.size(); }
+
+  void
+  clear() noexcept
+  { ox.clear(); oy.clear(); dx.clear(); dy.clear(); }
+
+  void
+  push_back(const line_segment &seg)
+  {
+    ox.push_back(seg.origin.x);
+    oy.push_back(seg.origin.y);
+    dx.push_back(seg.direction.x);
+    dy.push_back(seg.direction.y);
+  }
+
+  line_segment
+  operator [] (size_t i) const noexcept
+  { return {{ox[i], oy[i]}, {dx[i], dy[i]}}; }
+}; // struct mw::segment_batch
+
+
+/**
+ * @brief Line segments of static obstacles indexed with a bounding volume
+ * hierarchy.
+ *
+ * Segments are added one by one and the index is built afterwards with
+ * build(); segments added after that are not visible to queries until the
+ * next build().
+ */
+class segment_table {
+  public:
+  void
+  clear();
+
+  bool
+  empty() const noexcept
+  { return m_segments.size() == 0; }
+
+  size_t
+  size() const noexcept
+  { return m_segments.size(); }
+
+  void
+  add(const line_segment &seg, phys_obstacle *owner);
+
+  void
+  build();
+
+  line_segment
+  get_segment(size_t i) const noexcept
+  { return m_segments[i]; }
+
+  /** @brief Obstacle the segment belongs to. */
+  phys_obstacle*
+  get_owner(size_t i) const noexcept
+  { return m_owners[i]; }
+
+  /**
+   * @brief Collect indices of segments whose bounding boxes overlap the
+   * bounding box of a circle.
+   *
+   * Indices are appended to @p result in ascending order.
+   */
+  void
+  query(const circle &c, std::vector<uint32_t> &result) const;
+
+  /** @brief Copy given segments into a batch (the batch is cleared first). */
+  void
+  gather(const std::vector<uint32_t> &idxs, segment_batch &batch) const;
+
+  private:
+  segment_batch m_segments;
+  std::vector<phys_obstacle*> m_owners;
+  aabb_tree m_tree;
+}; // class mw::segment_table
+
+} // namespace mw
+
+#endif
@@ -0,0 +1,84 @@
+/**
+ * @file shadow_mesh.hpp
+ * @brief Shadow polygons rendered in a single batch
+ */
+#ifndef SHADOW_MESH_HPP
+#define SHADOW_MESH_HPP
+
+#include "geometry.hpp"
+#include "common.hpp"
+#include "vision.hpp"
+
+#include <SDL2/SDL.h>
+
+
+namespace mw {
+
+/** @addtogroup Vision
+ * @{
+ */
+
+/**
+ * @brief Convex polygons triangulated into a shared vertex/index buffer.
+ *
+ * All polygons are submitted with a single `SDL_RenderGeometry()` call. When it
+ * is disabled or fails, polygons are filled one by one with SDL2_gfx as
+ * before.
+ */
+class shadow_mesh {
+  public:
+  /** @brief Enable or disable `SDL_RenderGeometry()` for all meshes. */
+  static void
+  set_use_geometry(bool enable) noexcept
+  { gm_use_geometry = enable; }
+
+  static bool
+  get_use_geometry() noexcept
+  { return gm_use_geometry; }
+
+  void
+  clear() noexcept
+  {
+    m_vertices.clear();
+    m_indices.clear();
+    m_polygons.clear();
+  }
+
+  bool
+  empty() const noexcept
+  { return m_polygons.empty(); }
+
+  /**
+   * @brief Add a convex polygon.
+   * @param points Vertices of the polygon ordered around its center.
+   * @param world_to_target Mapping from @p points to the render target.
+   * @param color Fill color.
+   */
+  void
+  add_polygon(const vision_vector<pt2d_d> &points,
+      const mapping &world_to_target, color_t color);
+
+  /**
+   * @brief Fill all the polygons using current draw blend mode of the
+   * renderer.
+   */
+  void
+  render(SDL_Renderer *rend) const;
+
+  private:
+  void
+  _render_polygons(SDL_Renderer *rend) const;
+
+  static bool gm_use_geometry;
+
+  vision_vector<SDL_Vertex> m_vertices;
+  vision_vector<int> m_indices;
+  // index of the first vertex of each polygon
+  vision_vector<size_t> m_polygons;
+}; // class mw::shadow_mesh
+
+/** @} */
+
+} // namespace mw
+
+#endif
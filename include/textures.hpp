@@ -6,6 +6,9 @@
 #include <SDL2/SDL.h>
 
 #include <unordered_map>
+#include <map>
+#include <deque>
+#include <vector>
 #include <string>
 
 
@@ -45,9 +48,105 @@ class texture_storage {
 SDL_Texture*
 create_texture(SDL_Renderer *rend, int access, int w, int h);
 
+
+/**
+ * @brief Render-target textures kept for reuse.
+ *
+ * Requested sizes are rounded up to multiples of 64 pixels, so that textures
+ * of similar sizes (e.g. the same glow at a slightly different zoom) land in
+ * the same bucket. Only the top-left part of the requested size should be used
+ * of an acquired texture; its contents are undefined.
+ *
+ * Free textures are kept while their total area stays within a limit; beyond
+ * it, the ones released the earliest are destroyed.
+ */
+class render_target_pool {
+  public:
+  static constexpr int granularity = 64;
+
+  render_target_pool(SDL_Renderer *rend)
+  : m_rend {rend},
+    m_ncreated {0},
+    m_free_pixels {0},
+    m_max_free_pixels {size_t(1) << 24},
+    m_stamp {0}
+  { }
+
+  ~render_target_pool();
+
+  /** @brief Get a target of at least @p w x @p h pixels. */
+  SDL_Texture*
+  acquire(int w, int h);
+
+  /** @brief Return a texture obtained with acquire() to the pool. */
+  void
+  release(SDL_Texture *tex);
+
+  /** @brief Number of textures created by the pool so far. */
+  size_t
+  get_n_created() const noexcept
+  { return m_ncreated; }
+
+  /** @brief Limit the total area (in pixels) of free textures. */
+  void
+  set_max_free_pixels(size_t n);
+
+  render_target_pool(const render_target_pool&) = delete;
+  render_target_pool(render_target_pool&&) = delete;
+  render_target_pool& operator = (const render_target_pool&) = delete;
+  render_target_pool& operator = (render_target_pool&&) = delete;
+
+  private:
+  struct free_texture {
+    SDL_Texture *tex;
+    std::pair<int, int> size;
+  };
+
+  void
+  _trim();
+
+  SDL_Renderer *m_rend;
+  // free textures by their release stamps, i.e. from the earliest released
+  std::map<size_t, free_texture> m_released;
+  // release stamps of free textures by their size, in increasing order
+  std::map<std::pair<int, int>, std::deque<size_t>> m_free;
+  size_t m_ncreated;
+  size_t m_free_pixels;
+  size_t m_max_free_pixels;
+  size_t m_stamp;
+}; // class mw::render_target_pool
+
+
 SDL_Texture*
 get_render_target(SDL_Renderer *rend) noexcept;
 
+/**
+ * @brief Blend mode for textures whose colors are premultiplied by alpha (e.g.
+ * ones drawn with blending over a transparent background).
+ */
+SDL_BlendMode
+premultiplied_blend_mode();
+
+/**
+ * @brief Same as premultiplied_blend_mode(), but leaves alpha of the target
+ * intact.
+ */
+SDL_BlendMode
+premultiplied_color_blend_mode();
+
+/**
+ * @brief Blend mode accumulating light: `rgb += src*alpha`, `alpha += alpha`.
+ */
+SDL_BlendMode
+light_blend_mode();
+
+/**
+ * @brief Blend mode lighting up a texture by accumulated light: `rgb +=
+ * src*dst_alpha`, target alpha intact.
+ */
+SDL_BlendMode
+lit_blend_mode();
+
 void
 set_render_target(SDL_Renderer *rend, SDL_Texture *target);
 
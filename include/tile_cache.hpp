@@ -0,0 +1,76 @@
+/**
+ * @file tile_cache.hpp
+ * @brief Textures of a layer pre-rendered in square tiles
+ */
+#ifndef TILE_CACHE_HPP
+#define TILE_CACHE_HPP
+
+#include "textures.hpp"
+
+#include <SDL2/SDL.h>
+
+#include <unordered_map>
+#include <cstdint>
+
+
+namespace mw {
+
+/**
+ * @brief Tiles of a layer rendered at discrete zoom levels.
+ *
+ * A tile covers a square of `tile_size` pixels at the scale of its level;
+ * scales of consecutive levels differ by the factor of 2^(1/4). Tiles which
+ * were not used during the last frame are returned to the pool of render
+ * targets.
+ */
+class tile_cache {
+  public:
+  static constexpr int tile_size = 256;
+
+  explicit
+  tile_cache(render_target_pool &pool): m_pool {pool}, m_frame {0} { }
+
+  ~tile_cache()
+  { clear(); }
+
+  /** @brief Get a level whose scale is the closest to a given one. */
+  static int
+  get_level(double scale) noexcept;
+
+  static double
+  get_level_scale(int level) noexcept;
+
+  /**
+   * @brief Get a tile.
+   * @param[out] is_new Set to `true` when the tile has to be rendered.
+   */
+  SDL_Texture*
+  get(int level, int ix, int iy, bool &is_new);
+
+  /** @brief Drop tiles not used since the previous call. */
+  void
+  next_frame();
+
+  /** @brief Drop all tiles (e.g. when contents of the layer change). */
+  void
+  clear();
+
+  tile_cache(const tile_cache&) = delete;
+  tile_cache(tile_cache&&) = delete;
+  tile_cache& operator = (const tile_cache&) = delete;
+  tile_cache& operator = (tile_cache&&) = delete;
+
+  private:
+  struct entry {
+    SDL_Texture *tex;
+    size_t frame;
+  };
+
+  render_target_pool &m_pool;
+  std::unordered_map<uint64_t, entry> m_tiles;
+  size_t m_frame;
+}; // class mw::tile_cache
+
+} // namespace mw
+
+#endif
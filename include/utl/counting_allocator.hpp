@@ -0,0 +1,68 @@
+#ifndef UTL_COUNTING_ALLOCATOR_HPP
+#define UTL_COUNTING_ALLOCATOR_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+
+namespace mw {
+inline namespace utl {
+
+/** @brief Counter of allocations shared by allocators with the same tag. */
+template <typename Tag>
+struct allocation_counter {
+  static std::atomic<size_t>&
+  get() noexcept
+  {
+    static std::atomic<size_t> n {0};
+    return n;
+  }
+
+  /** @brief Number of allocations made so far (by all threads). */
+  static size_t
+  count() noexcept
+  { return get().load(std::memory_order_relaxed); }
+};
+
+
+/**
+ * @brief Standard allocator that counts the allocations it makes (see
+ * allocation_counter).
+ */
+template <typename T, typename Tag>
+struct counting_allocator {
+  typedef T value_type;
+
+  counting_allocator() noexcept = default;
+
+  template <typename U>
+  counting_allocator(const counting_allocator<U, Tag>&) noexcept { }
+
+  template <typename U>
+  struct rebind { typedef counting_allocator<U, Tag> other; };
+
+  T*
+  allocate(size_t n)
+  {
+    allocation_counter<Tag>::get().fetch_add(1, std::memory_order_relaxed);
+    return std::allocator<T> {}.allocate(n);
+  }
+
+  void
+  deallocate(T *p, size_t n) noexcept
+  { std::allocator<T> {}.deallocate(p, n); }
+
+  template <typename U> bool
+  operator == (const counting_allocator<U, Tag>&) const noexcept
+  { return true; }
+
+  template <typename U> bool
+  operator != (const counting_allocator<U, Tag>&) const noexcept
+  { return false; }
+}; // struct mw::utl::counting_allocator
+
+} // namespace mw::utl
+} // namespace mw
+
+#endif
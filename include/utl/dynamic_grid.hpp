@@ -6,6 +6,8 @@
 
 #include "boost/format.hpp"
 
+#include <algorithm>
+
 
 namespace mw {
 inline namespace utl {
@@ -65,8 +67,8 @@ class dynamic_grid {
   { ++m_current_time; }
 
   class cell_view {
-    cell_view(const cell &mycell)
-    : m_cell {mycell}
+    cell_view(const cell &mycell, size_t nvalues)
+    : m_cell {mycell}, m_nvalues {nvalues}
     { }
 
     public:
@@ -83,11 +85,11 @@ class dynamic_grid {
 
     iterator
     end() const noexcept
-    { return m_cell.values.end(); }
+    { return m_cell.values.begin() + m_nvalues; }
 
     reverse_iterator
     rbegin() const noexcept
-    { return m_cell.values.rbegin(); }
+    { return reverse_iterator {end()}; }
 
     reverse_iterator
     rend() const noexcept
@@ -95,13 +97,19 @@ class dynamic_grid {
 
     private:
     const cell &m_cell;
+    // dynamic values left from previous time points are not visible
+    size_t m_nvalues;
 
     friend class dynamic_grid;
   };
 
   cell_view
   at(size_t ix, size_t iy) const
-  { return cell_view {m_cells[_get_cell_index(ix, iy)]}; }
+  {
+    const cell &c = m_cells[_get_cell_index(ix, iy)];
+    const bool uptodate = c.timestamp == m_current_time;
+    return cell_view {c, uptodate ? c.values.size() : c.n_statics};
+  }
 
   template <typename ...Args> void
   put(size_t ix, size_t iy, Args&& ...args)
@@ -119,6 +127,21 @@ class dynamic_grid {
     c.put_static(std::forward<Args>(args)...);
   }
 
+  /**
+   * @brief Remove dynamic values put since the last tick which satisfy a
+   * predicate; order of remaining values is preserved.
+   */
+  template <typename Pred> void
+  remove_if(size_t ix, size_t iy, Pred&& pred)
+  {
+    cell &c = m_cells[_get_cell_index(ix, iy)];
+    if (c.timestamp != m_current_time)
+      return;
+    const auto begin = c.values.begin() + c.n_statics;
+    c.values.erase(std::remove_if(begin, c.values.end(), pred),
+        c.values.end());
+  }
+
   private:
   const values_collection&
   _get_values(size_t ix, size_t iy) const
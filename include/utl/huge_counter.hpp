@@ -25,7 +25,8 @@ class huge_counter {
   operator ++ ()
   {
     try { _increment(0); }
-    catch (const exception &exn) { throw exn.in(__func__); }
+    catch (exception &exn) { throw exn.in(__func__); }
+    return *this;
   }
 
   huge_counter
@@ -33,7 +34,7 @@ class huge_counter {
   {
     huge_counter ret = *this;
     try { _increment(0); }
-    catch (const exception &exn) { throw exn.in(__func__); }
+    catch (exception &exn) { throw exn.in(__func__); }
     return ret;
   }
 
@@ -79,7 +80,7 @@ class huge_counter {
         ++m_counters[i];
       else
       {
-        m_counters[i] == 0;
+        m_counters[i] = 0;
         _increment(i + 1);
       }
     }
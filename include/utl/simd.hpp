@@ -0,0 +1,73 @@
+#ifndef UTL_SIMD_HPP
+#define UTL_SIMD_HPP
+
+#if defined(__AVX__) || defined(__SSE2__)
+# include <immintrin.h>
+# include <cstddef>
+
+
+namespace mw {
+inline namespace utl {
+
+/**
+ * @brief Operations on packed doubles of the widest available instruction set
+ * (AVX or SSE2).
+ *
+ * Only compiled in when either of them is enabled, i.e. when `__AVX__` or
+ * `__SSE2__` is defined; users must provide a scalar fallback.
+ */
+#if defined(__AVX__)
+struct simd_ops {
+  typedef __m256d type;
+  static constexpr size_t width = 4;
+  static type set1(double x) { return _mm256_set1_pd(x); }
+  static type load(const double *p) { return _mm256_loadu_pd(p); }
+  static void store(double *p, type a) { _mm256_storeu_pd(p, a); }
+  static type add(type a, type b) { return _mm256_add_pd(a, b); }
+  static type sub(type a, type b) { return _mm256_sub_pd(a, b); }
+  static type mul(type a, type b) { return _mm256_mul_pd(a, b); }
+  static type div(type a, type b) { return _mm256_div_pd(a, b); }
+  static type sqrt(type a) { return _mm256_sqrt_pd(a); }
+  static type max(type a, type b) { return _mm256_max_pd(a, b); }
+  static type min(type a, type b) { return _mm256_min_pd(a, b); }
+  static type bit_and(type a, type b) { return _mm256_and_pd(a, b); }
+  static type bit_andnot(type a, type b) { return _mm256_andnot_pd(a, b); }
+  static type bit_or(type a, type b) { return _mm256_or_pd(a, b); }
+  static type ge(type a, type b) { return _mm256_cmp_pd(a, b, _CMP_GE_OQ); }
+  static type gt(type a, type b) { return _mm256_cmp_pd(a, b, _CMP_GT_OQ); }
+  static type le(type a, type b) { return _mm256_cmp_pd(a, b, _CMP_LE_OQ); }
+  static type lt(type a, type b) { return _mm256_cmp_pd(a, b, _CMP_LT_OQ); }
+  /** @brief Gather sign bits of lanes (e.g. of a comparison result). */
+  static int mask(type a) { return _mm256_movemask_pd(a); }
+};
+#else
+struct simd_ops {
+  typedef __m128d type;
+  static constexpr size_t width = 2;
+  static type set1(double x) { return _mm_set1_pd(x); }
+  static type load(const double *p) { return _mm_loadu_pd(p); }
+  static void store(double *p, type a) { _mm_storeu_pd(p, a); }
+  static type add(type a, type b) { return _mm_add_pd(a, b); }
+  static type sub(type a, type b) { return _mm_sub_pd(a, b); }
+  static type mul(type a, type b) { return _mm_mul_pd(a, b); }
+  static type div(type a, type b) { return _mm_div_pd(a, b); }
+  static type sqrt(type a) { return _mm_sqrt_pd(a); }
+  static type max(type a, type b) { return _mm_max_pd(a, b); }
+  static type min(type a, type b) { return _mm_min_pd(a, b); }
+  static type bit_and(type a, type b) { return _mm_and_pd(a, b); }
+  static type bit_andnot(type a, type b) { return _mm_andnot_pd(a, b); }
+  static type bit_or(type a, type b) { return _mm_or_pd(a, b); }
+  static type ge(type a, type b) { return _mm_cmpge_pd(a, b); }
+  static type gt(type a, type b) { return _mm_cmpgt_pd(a, b); }
+  static type le(type a, type b) { return _mm_cmple_pd(a, b); }
+  static type lt(type a, type b) { return _mm_cmplt_pd(a, b); }
+  static int mask(type a) { return _mm_movemask_pd(a); }
+};
+#endif
+
+} // namespace mw::utl
+} // namespace mw
+
+#endif // __AVX__ || __SSE2__
+
+#endif
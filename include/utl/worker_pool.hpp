@@ -0,0 +1,156 @@
+#ifndef UTL_WORKER_POOL_HPP
+#define UTL_WORKER_POOL_HPP
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <exception>
+#include <vector>
+
+
+namespace mw {
+inline namespace utl {
+
+/**
+ * @brief Persistent set of threads for data-parallel loops
+ *
+ * A loop is split into size() contiguous chunks; the first chunk is run by the
+ * calling thread, the rest by the pool threads. Chunk number @p k always
+ * covers the same sub-range for a given loop size, so results merged in the
+ * order of chunks do not depend on scheduling.
+ */
+class worker_pool {
+  public:
+  explicit
+  worker_pool(size_t nworkers = std::thread::hardware_concurrency())
+  : m_generation {0},
+    m_pending {0},
+    m_stop {false}
+  {
+    for (size_t i = 1; i < nworkers; ++i)
+      m_threads.emplace_back([this, i] { _run_worker(i); });
+  }
+
+  ~worker_pool()
+  {
+    {
+      std::lock_guard _ {m_mtx};
+      m_stop = true;
+    }
+    m_wake.notify_all();
+    for (std::thread &thr : m_threads)
+      thr.join();
+  }
+
+  worker_pool(const worker_pool&) = delete;
+  worker_pool& operator = (const worker_pool&) = delete;
+
+  /** @brief Pool shared by the whole application. */
+  static worker_pool&
+  instance()
+  {
+    static worker_pool self;
+    return self;
+  }
+
+  /** @brief Number of chunks a loop is split into (including the caller). */
+  size_t
+  size() const noexcept
+  { return m_threads.size() + 1; }
+
+  /**
+   * @brief Call `f(ichunk, begin, end)` for each chunk of [0, @p n) and wait
+   * until all of them are done.
+   *
+   * Exceptions thrown by @p f are rethrown in the calling thread.
+   */
+  template <typename F> void
+  for_each_chunk(size_t n, F&& f)
+  {
+    const size_t nchunks = size();
+    const auto run_chunk = [&] (size_t ichunk) {
+      f(ichunk, n*ichunk/nchunks, n*(ichunk + 1)/nchunks);
+    };
+
+    if (nchunks == 1 or n <= 1)
+    {
+      f(size_t(0), size_t(0), n);
+      return;
+    }
+
+    std::lock_guard _ {m_run_mtx};
+    {
+      std::lock_guard _ {m_mtx};
+      m_job = run_chunk;
+      m_pending = m_threads.size();
+      m_generation += 1;
+    }
+    m_wake.notify_all();
+
+    std::exception_ptr err;
+    try { run_chunk(0); }
+    catch (...) { err = std::current_exception(); }
+
+    std::unique_lock lock {m_mtx};
+    m_done.wait(lock, [this] { return m_pending == 0; });
+    m_job = nullptr;
+    if (not err)
+      std::swap(err, m_error);
+    m_error = nullptr;
+    lock.unlock();
+
+    if (err)
+      std::rethrow_exception(err);
+  }
+
+  private:
+  void
+  _run_worker(size_t ichunk)
+  {
+    size_t generation = 0;
+    while (true)
+    {
+      std::function<void(size_t)> job;
+      {
+        std::unique_lock lock {m_mtx};
+        m_wake.wait(lock, [&] {
+          return m_stop or m_generation != generation;
+        });
+        if (m_stop)
+          return;
+        generation = m_generation;
+        job = m_job;
+      }
+
+      std::exception_ptr err;
+      try { job(ichunk); }
+      catch (...) { err = std::current_exception(); }
+
+      std::lock_guard _ {m_mtx};
+      if (err and not m_error)
+        m_error = err;
+      if (--m_pending == 0)
+        m_done.notify_one();
+    }
+  }
+
+  private:
+  std::vector<std::thread> m_threads;
+  // serializes concurrent loops
+  std::mutex m_run_mtx;
+  // protects the fields below
+  std::mutex m_mtx;
+  std::condition_variable m_wake;
+  std::condition_variable m_done;
+  std::function<void(size_t)> m_job;
+  std::exception_ptr m_error;
+  size_t m_generation;
+  size_t m_pending;
+  bool m_stop;
+}; // class mw::utl::worker_pool
+
+} // namespace mw::utl
+} // namespace mw
+
+#endif
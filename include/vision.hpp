@@ -7,19 +7,23 @@
 #define VISION_HPP
 
 #include "geometry.hpp"
+#include "segment_table.hpp"
 #include "common.hpp"
 #include "exceptions.hpp"
 #include "logging.h"
+#include "utl/counting_allocator.hpp"
 
 #include <SDL2/SDL.h>
 
 #include <list>
 #include <vector>
+#include <memory>
 
 
 namespace mw {
 
 class vis_obstacle;
+class area_map;
 
 /** @defgroup Vision Vision
  * @brief Vision processing algorithms
@@ -39,6 +43,55 @@ fix_angle(double phi) noexcept
   return phi;
 }
 
+/**
+ * @name Sight angles
+ * Directional angles of sights (@ref sight.phi1, @ref sight.phi2).
+ *
+ * With `MW_VISION_PSEUDO_ANGLES` defined, these are not radians but a
+ * "diamond angle": a monotone function of the direction computed without
+ * transcendental functions. It is scaled to match radians at multiples of
+ * `M_PI_4` and turns by exactly `M_PI` for the opposite direction, so all
+ * the interval arithmetic below works on it unchanged.
+ *
+ * Angles on circles (@ref sight::sight_data_type::circle_sight_data_type) are
+ * always in radians.
+ * @{
+ */
+#ifdef MW_VISION_PSEUDO_ANGLES
+/** @brief Get the sight angle of a direction. */
+inline double
+sight_angle(const vec2d_d &v) noexcept
+{
+  const double ax = fabs(v.x), ay = fabs(v.y);
+  if (ax + ay == 0)
+    return 0;
+  const double q = ay/(ax + ay);
+  const double phi = M_PI_2*(v.x >= 0 ? q : 2 - q);
+  return copysign(phi, v.y);
+}
+
+/** @brief Get the unit vector pointing along a sight angle. */
+inline vec2d_d
+sight_direction(double phi) noexcept
+{
+  const double s = fabs(phi)/M_PI_2;
+  const double q = s <= 1 ? s : 2 - s;
+  const double x = s <= 1 ? 1 - q : q - 1;
+  const double y = copysign(q, phi);
+  const double norm = sqrt(x*x + y*y);
+  return {x/norm, y/norm};
+}
+#else
+inline double
+sight_angle(const vec2d_d &v) noexcept
+{ return dirangle(v); }
+
+inline vec2d_d
+sight_direction(double phi) noexcept
+{ return rotated(vec2d_d {1, 0}, phi); }
+#endif
+/** @} */
+
 /**
  * @brief Storage for sight information on some shape.
  */
@@ -92,7 +145,8 @@ struct sight {
    * @brief Directional angles defining segment of the sight *obscured by the
    * line segment* (WTF!?!?!).
    * @details Obscured segment of sight is then obtained as a counter-clockwise
-   * rotation from @ref sight.phi1 to @ref sight.phi2.
+   * rotation from @ref sight.phi1 to @ref sight.phi2. Angles are measured
+   * with sight_angle().
    */
   double phi1, phi2; // 2 x 8 = 16 bytes
   /** @} */
@@ -103,6 +157,31 @@ struct sight {
 static_assert(sizeof(sight) == 88);
 static_assert(alignof(sight) == 8);
 
+struct vision_allocator_tag;
+
+/** @brief Allocator of buffers used for vision processing. */
+template <typename T>
+using vision_allocator = counting_allocator<T, vision_allocator_tag>;
+
+template <typename T>
+using vision_vector = std::vector<T, vision_allocator<T>>;
+
+using sight_container = vision_vector<sight>;
+
+using vis_obstacle_list = vision_vector<const vis_obstacle*>;
+
+/**
+ * @brief Get the number of heap allocations made for vision buffers so far.
+ *
+ * Counted are buffers of vision processors, of shadow meshes, and the lists of
+ * obstacles, sights and light geometry reused by the area map, AI and vision
+ * caches between frames. Once they have warmed up, processing vision should
+ * not allocate.
+ */
+inline size_t
+vision_allocation_count() noexcept
+{ return allocation_counter<vision_allocator_tag>::count(); }
+
 inline bool
 same_identity(const sight &a, const sight &b)
 {
@@ -136,6 +215,17 @@ cast_sight(const circle &src, const circle &circ, sight &res) noexcept;
 bool
 cast_sight(const circle &src, const line_segment &line, sight &res) noexcept;
 
+/**
+ * @brief Compute sights on a batch of line segments.
+ *
+ * Same as cast_sight() for each segment (up to rounding), but the segments are
+ * clipped to the source circle several at a time with SIMD instructions (where
+ * available). Sights on segments within the circle are appended to @p out,
+ * with their auxiliary data set to the index of the segment in the batch.
+ */
+void
+cast_sights(const circle &src, const segment_batch &segs, sight_container &out);
+
 /**
  * @brief Check if an angle is contained in a given open interval.
  * @param a A pair of angles defining the interval via counter-clockwise
@@ -336,12 +426,12 @@ study_box(const pt2d_d &src, const rectangle &box, box_info &res);
 void
 cast_shadows_in_the_box(const pt2d_d &src, const line_segment &line, double t1,
     double t2, double phi1, double phi2, const rectangle &box,
-    const box_info &boxinfo, std::vector<pt2d_d> &out);
+    const box_info &boxinfo, vision_vector<pt2d_d> &out);
 
 void
 cast_shadows_on_the_box(const pt2d_d &src, const line_segment &line, double t1,
     double t2, double phi1, double phi2, const rectangle &box,
-    const box_info &boxinfo, std::vector<pt2d_d> &out);
+    const box_info &boxinfo, vision_vector<pt2d_d> &out);
 
 /**
  * @brief Check if one obstacle is located "before" the other with respect to
@@ -362,41 +452,103 @@ void
 adjust_sight(const circle &source, sight &s, double new_phi1, double new_phi2);
 
 
+/** @brief Algorithm used by vision_processor::process(). */
+enum class vision_engine {
+  /** Test each sight against all the others in rounds; quadratic. */
+  pairwise,
+  /**
+   * Sweep the ends of sights sorted by angle keeping the active sights in
+   * heaps ordered by distance; O(n log n).
+   */
+  angular_sweep,
+};
+
+
+struct vision_scratch;
+
+struct vision_scratch_deleter {
+  void operator () (vision_scratch *scratch) const noexcept;
+};
+
 class vision_processor {
   public:
   static constexpr char class_name[] = "mw::vision_processor";
   using exception = scoped_exception<class_name>;
 
-  using sight_container = std::vector<sight>;
+  using sight_container = mw::sight_container;
   using iterator = sight_container::iterator;
   using const_iterator = sight_container::const_iterator;
 
   vision_processor()
   : m_curobs {nullptr},
-    m_ignore {nullptr}
+    m_ignore {nullptr},
+    m_engine {vision_engine::pairwise},
+    m_incremental {false}
   { }
 
   vision_processor(const circle &source)
   : m_source {source},
     m_curobs {nullptr},
-    m_ignore {nullptr}
+    m_ignore {nullptr},
+    m_engine {vision_engine::pairwise},
+    m_incremental {false}
   { }
 
   vision_processor(vision_processor &&other)
   : m_source {other.m_source},
     m_curobs {nullptr},
-    m_ignore {other.m_ignore}
-  { std::swap(m_sights, other.m_sights); }
+    m_ignore {other.m_ignore},
+    m_engine {other.m_engine},
+    m_incremental {other.m_incremental}
+  {
+    std::swap(m_sights, other.m_sights);
+    std::swap(m_scratch, other.m_scratch);
+  }
 
   vision_processor&
   operator = (vision_processor &&other) noexcept
   {
     m_source = other.m_source;
     std::swap(m_sights, other.m_sights);
+    std::swap(m_scratch, other.m_scratch);
     m_ignore = other.m_ignore;
+    m_engine = other.m_engine;
+    m_incremental = other.m_incremental;
     return *this;
   }
 
+  /**
+   * @brief Select the algorithm for process().
+   *
+   * Both engines produce visible parts of the loaded sights (possibly split
+   * differently, and in different order). Defaults to
+   * vision_engine::pairwise.
+   */
+  void
+  set_engine(vision_engine engine) noexcept
+  { m_engine = engine; }
+
+  vision_engine
+  get_engine() const noexcept
+  { return m_engine; }
+
+  /**
+   * @brief Let process() start from the results of the previous call.
+   *
+   * Meant for processors reloaded each frame with the same obstacles from a
+   * slightly moved source: only the intervals of directions where the order
+   * of sight ends has changed are processed again. Falls back to a full pass
+   * when the loaded sights differ from the previous ones or too many of their
+   * ends are reordered. Applies to vision_engine::angular_sweep only.
+   */
+  void
+  set_incremental(bool enable) noexcept
+  { m_incremental = enable; }
+
+  bool
+  is_incremental() const noexcept
+  { return m_incremental; }
+
   void
   set_source(const circle &source) noexcept
   { m_source = source; }
@@ -413,6 +565,10 @@ class vision_processor {
   set_ignore(const vis_obstacle *obs) noexcept
   { m_ignore = obs; }
 
+  const vis_obstacle*
+  get_ignore() const noexcept
+  { return m_ignore; }
+
   class const_sights_view {
     public:
     const_sights_view(const vision_processor &visproc): m_visproc {visproc} { }
@@ -444,6 +600,13 @@ class vision_processor {
   //sort_sights(Compare cmp)
   //{ m_sights.sort(cmp);a }
 
+  /**
+   * @brief Add sights of given vis-obstacles.
+   *
+   * Line segments of obstacles providing them (see
+   * vis_obstacle::get_sight_segments()) are cast together after all other
+   * obstacles.
+   */
   template <typename Iterator>
   void
   load_obstacles(Iterator begin, Iterator end)
@@ -459,6 +622,8 @@ class vision_processor {
         m_curobs = obs;
         _load_obstacle(obs);
       }
+      m_curobs = nullptr;
+      _flush_line_sights();
     }
     catch (const std::exception &exn)
     {
@@ -477,15 +642,23 @@ class vision_processor {
   load_obstacle(const vis_obstacle *obs)
   { load_obstacles(&obs, &obs+1); }
 
-  //template <typename Iterator>
-  //void
-  //load_sights(Iterator begin, Iterator end)
-  //{ m_sights.insert(m_sights.end(), begin, end); }
+  /**
+   * @brief Load vis-obstacles of the map located close to the source.
+   * @see area_map::collect_vis_obstacles()
+   */
+  void
+  load_obstacles(const area_map &map);
 
-  //template <typename Container>
-  //void
-  //load_sights(Container container)
-  //{ m_sights.insert(m_sights.end(), container. begin(), container.end()); }
+  /** @brief Add sights computed elsewhere (for the same source). */
+  template <typename Iterator>
+  void
+  load_sights(Iterator begin, Iterator end)
+  { m_sights.insert(m_sights.end(), begin, end); }
+
+  template <typename Container>
+  void
+  load_sights(const Container &container)
+  { load_sights(container.begin(), container.end()); }
 
   void
   process();
@@ -521,6 +694,26 @@ class vision_processor {
     m_sights.emplace_back(s);
   }
 
+  /**
+   * @brief Add sights on line segments of the obstacle being loaded (see
+   * cast_sights()).
+   *
+   * Auxiliary data of each sight is set to the index of its segment.
+   */
+  void
+  add_line_sights(const segment_batch &segs)
+  {
+    if (m_curobs == nullptr)
+    {
+      error("m_currobs == (null)");
+      abort();
+    }
+    const size_t first = m_sights.size();
+    cast_sights(get_source(), segs, m_sights);
+    for (size_t i = first; i < m_sights.size(); ++i)
+      m_sights[i].static_data.obs = m_curobs;
+  }
+
   /** @todo TODO: Dont do anything when the texture is completely covered
    * by shadows.
    */
@@ -532,10 +725,20 @@ class vision_processor {
   void
   _load_obstacle(const vis_obstacle *obs);
 
+  void
+  _flush_line_sights();
+
+  vision_scratch&
+  _scratch() const;
+
   std::optional<circle> m_source;
   sight_container m_sights;
+  // buffers reused by process(), apply() etc. (allocated on first use)
+  mutable std::unique_ptr<vision_scratch, vision_scratch_deleter> m_scratch;
   const vis_obstacle *m_curobs;
   const vis_obstacle *m_ignore;
+  vision_engine m_engine;
+  bool m_incremental;
 };
 
 /** @} */
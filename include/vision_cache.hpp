@@ -0,0 +1,88 @@
+/**
+ * @file vision_cache.hpp
+ * @brief Vision re-processed only when it may have changed
+ */
+#ifndef VISION_CACHE_HPP
+#define VISION_CACHE_HPP
+
+#include "vision.hpp"
+
+
+namespace mw {
+
+class area_map;
+
+/** @addtogroup Vision
+ * @{
+ */
+
+/**
+ * @brief Keeps processed vision of a map from a (slowly) moving source.
+ *
+ * Sights on immutable obstacles (see vis_obstacle::is_immutable()) are
+ * processed against each other only when the source moves further than a
+ * given distance from the point the vision was computed for. Only their
+ * visible parts are then combined with sights on other obstacles, and the
+ * result is reused until any of these sights change.
+ */
+class vision_cache {
+  public:
+  explicit
+  vision_cache(double epsilon = 0.1)
+  : m_epsilon {epsilon},
+    m_valid {false},
+    m_ignore {nullptr}
+  {
+    // global vision covers the whole map: too many sights to test pairwise
+    m_vision.set_engine(vision_engine::angular_sweep);
+    m_immutables_vision.set_engine(vision_engine::angular_sweep);
+  }
+
+  /** @brief Set how far the source may move before vision is recomputed. */
+  void
+  set_epsilon(double epsilon) noexcept
+  { m_epsilon = epsilon; }
+
+  /** @brief Force recomputation on the next update(). */
+  void
+  invalidate() noexcept
+  { m_valid = false; }
+
+  /**
+   * @brief Bring the vision up to date.
+   *
+   * @param map Map to take vis-obstacles from.
+   * @param source Source of the vision.
+   * @param ignore Obstacle to be ignored (e.g. the observer itself).
+   * @return Processed vision. Its source may differ from @p source by at most
+   * the epsilon.
+   */
+  const vision_processor&
+  update(const area_map &map, const circle &source, const vis_obstacle *ignore);
+
+  const vision_processor&
+  get() const noexcept
+  { return m_vision; }
+
+  private:
+  double m_epsilon;
+  bool m_valid;
+  circle m_source;
+  const vis_obstacle *m_ignore;
+  // immutable obstacles and visible parts of their sights
+  vis_obstacle_list m_immutables;
+  vision_processor::sight_container m_immutable_sights;
+  // sights on other obstacles
+  vision_processor::sight_container m_mutable_sights;
+  vision_processor m_vision;
+  // kept to reuse their buffers on each update
+  vis_obstacle_list m_obstacles;
+  vision_processor m_immutables_vision;
+  vision_processor m_mutables_vision;
+}; // class mw::vision_cache
+
+/** @} */
+
+} // namespace mw
+
+#endif
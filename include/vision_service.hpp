@@ -0,0 +1,75 @@
+/**
+ * @file vision_service.hpp
+ * @brief Vision of many observers processed in parallel
+ */
+#ifndef VISION_SERVICE_HPP
+#define VISION_SERVICE_HPP
+
+#include "vision.hpp"
+#include "utl/worker_pool.hpp"
+
+#include <vector>
+
+
+namespace mw {
+
+class area_map;
+
+/** @addtogroup Vision
+ * @{
+ */
+
+/**
+ * @brief Collects requests for vision and processes all of them at once.
+ *
+ * Requests are processed concurrently; the map must not be modified while
+ * run() is in progress, so that all observers see the same state of the map.
+ */
+class vision_service {
+  public:
+  vision_service(): m_pool {nullptr} { }
+
+  /** @brief Use given pool to run requests (pass nullptr to run serially). */
+  void
+  set_worker_pool(worker_pool *pool) noexcept
+  { m_pool = pool; }
+
+  size_t
+  size() const noexcept
+  { return m_requests.size(); }
+
+  void
+  clear() noexcept
+  { m_requests.clear(); }
+
+  /**
+   * @brief Ask to process vision from @p source into @p target.
+   *
+   * The target is overwritten by run(). It must stay alive until then and
+   * must not be shared with other requests.
+   */
+  void
+  request(const circle &source, const vis_obstacle *ignore,
+      vision_processor &target)
+  { m_requests.push_back({source, ignore, &target}); }
+
+  /** @brief Process all pending requests and clear the queue. */
+  void
+  run(const area_map &map);
+
+  private:
+  struct request_type {
+    circle source;
+    const vis_obstacle *ignore;
+    vision_processor *target;
+  };
+
+  std::vector<request_type> m_requests;
+  worker_pool *m_pool;
+}; // class mw::vision_service
+
+/** @} */
+
+} // namespace mw
+
+#endif
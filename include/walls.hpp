@@ -3,6 +3,7 @@
 
 #include "object.hpp"
 #include "area_map.hpp"
+#include "physics.hpp"
 #include "common.hpp"
 #include "vision.hpp"
 
@@ -28,7 +29,7 @@ class basic_wall: public phys_obstacle, public vis_obstacle {
   basic_wall(const std::vector<pt2d_d> &vertices)
   : m_vertices {vertices},
     m_color {0xFFFFFFFF}
-  { }
+  { _update_segments(); }
 
   virtual void
   set_color(color_t color) noexcept
@@ -53,41 +54,13 @@ class basic_wall: public phys_obstacle, public vis_obstacle {
   vec2d_d
   act_on_object(area_map &map, phys_object *subj) override
   {
+    const circle body {subj->get_position(), subj->get_radius()};
     vec2d_d force = {0, 0};
     for (size_t j = 1; j < m_vertices.size(); ++j)
     {
       const size_t i = j - 1;
-      const vec2d_d walldir = m_vertices[j] - m_vertices[i];
-      const line_segment wall {m_vertices[i], walldir};
-
-      sight s;
-      const double r = subj->get_radius();
-      if (cast_sight({subj->get_position(), subj->get_radius()}, wall, s))
-      {
-        const double dphi = interval_size({s.phi1, s.phi2});
-        const double sector_area = r*r*dphi/2;
-        const double triang_area = r*r*sin(dphi/2)*cos(dphi/2);
-        const double overlap_area = sector_area - triang_area;
-        vec2d_d n = normalized(vec2d_d(-walldir.y, walldir.x));
-        n = n * copysign(1., dot(n, subj->get_position() - wall(s.sight_data.line.t1)));
-        force = force + overlap_area * n;
-
-        // special treatment for corners
-        double t1 = s.sight_data.line.t1;
-        double t2 = s.sight_data.line.t2;
-        if (t1 > t2)
-          std::swap(t1, t2);
-        if (t1 == 0)
-        {
-          const vec2d_d r = subj->get_position() - wall(t1);
-          force = force + normalized(r)*(subj->get_radius() - mag(r))/2;
-        }
-        if (t2 == 1)
-        {
-          const vec2d_d r = subj->get_position() - wall(t2);
-          force = force + normalized(r)*(subj->get_radius() - mag(r))/2;
-        }
-      }
+      const line_segment wall {m_vertices[i], m_vertices[j] - m_vertices[i]};
+      force = force + overlap_force(body, wall);
     }
     return force;
   }
@@ -110,17 +83,59 @@ class basic_wall: public phys_obstacle, public vis_obstacle {
   sample_point() const override
   { return m_vertices.front(); }
 
+  bool
+  sweep(const tunnel &path, double &t, vec2d_d &n) const override
+  {
+    bool hit = false;
+    for (size_t j = 1; j < m_vertices.size(); ++j)
+    {
+      const size_t i = j - 1;
+      const line_segment wall {m_vertices[i], m_vertices[j] - m_vertices[i]};
+      double tcur;
+      vec2d_d ncur;
+      if (sweep_tunnel_linesegm(path, wall, tcur, ncur) and
+          (not hit or tcur < t))
+      {
+        t = tcur;
+        n = ncur;
+        hit = true;
+      }
+    }
+    return hit;
+  }
+
+  bool
+  get_segments(std::vector<line_segment> &segs) const override
+  {
+    for (size_t j = 1; j < m_vertices.size(); ++j)
+      segs.push_back({m_vertices[j-1], m_vertices[j] - m_vertices[j-1]});
+    return true;
+  }
+
+  bool
+  is_immutable() const override
+  { return true; }
+
   void
   get_sights(vision_processor &visproc) const override
+  { visproc.add_line_sights(m_segments); }
+
+  const segment_batch*
+  get_sight_segments() const override
+  { return &m_segments; }
+
+  bool
+  obscures(const line_segment &ray) const override
   {
     for (size_t j = 1; j < m_vertices.size(); ++j)
     {
       const size_t i = j - 1;
       const line_segment wall {m_vertices[i], m_vertices[j] - m_vertices[i]};
-      sight s;
-      if (cast_sight(visproc.get_source(), wall, s))
-        visproc.add_sight(s, i);
+      double t1, t2;
+      if (intersect(ray, wall, t1, t2) == 1)
+        return true;
     }
+    return false;
   }
 
   void
@@ -136,8 +151,21 @@ class basic_wall: public phys_obstacle, public vis_obstacle {
   }
 
   protected:
+  /** @brief Must be called whenever vertices are changed. */
+  void
+  _update_segments()
+  {
+    m_segments.clear();
+    for (size_t j = 1; j < m_vertices.size(); ++j)
+      m_segments.push_back({m_vertices[j-1], m_vertices[j] - m_vertices[j-1]});
+  }
+
   std::vector<pt2d_d> m_vertices;
   color_t m_color;
+
+  private:
+  // segments between vertices, for vision
+  segment_batch m_segments;
 }; // class basic_wall
 
 
@@ -147,7 +175,10 @@ class filled_wall: public basic_wall<solid_ends> {
   : basic_wall(vertices),
     m_edge_color {m_color},
     m_fill_color {m_color}
-  { m_vertices.push_back(m_vertices[0]); }
+  {
+    m_vertices.push_back(m_vertices[0]);
+    _update_segments();
+  }
 
   void
   set_color(color_t color) noexcept override
@@ -25,11 +25,22 @@ mw::area_map::area_map(sdl_environment &sdl, texture_storage &texstorage)
   m_width {500},
   m_height {500},
   m_has_walls {false},
+  m_interpolation {1},
   m_texstorage {texstorage},
+  m_render_targets {sdl.get_renderer()},
+  m_static_tiles {m_render_targets},
+  m_static_version {0},
+  m_physics {new md_physics},
   m_vicinity_grid {size_t(m_width) / 5, size_t(m_height) / 5},
+  m_grid_stamp {0},
+  m_deferred_lighting {false},
+  m_light_resolution {1},
   m_msglog {sdl, video_manager::instance().get_font(),
     color_manager::instance()["Normal"], 800, 200}
-{ }
+{
+  m_glow_vision.set_engine(vision_engine::angular_sweep);
+  m_glow_vision.set_incremental(true);
+}
 
 mw::area_map::~area_map()
 {
@@ -154,6 +165,43 @@ mw::area_map::build_grid()
       }
     }
   });
+
+  _index_static_segments();
+}
+
+void
+mw::area_map::_index_static_segments()
+{
+  // hand previously indexed obstacles back to the physics processor
+  for (object_entry &ent : m_objects)
+  {
+    if (ent.flags & oflag::is_indexed)
+    {
+      ent.flags &= ~oflag::is_indexed;
+      if (not ent.pobjit.has_value() and not ent.objptr->is_gone())
+        m_physics->add_obstacle(*ent.pobsit.value());
+    }
+  }
+
+  m_static_segments.clear();
+  std::vector<line_segment> segs;
+  for (object_entry &ent : m_objects)
+  {
+    if ((ent.flags & oflag::is_static) == 0 or not ent.pobsit.has_value() or
+        ent.pobjit.has_value() or ent.objptr->is_gone())
+      continue;
+
+    phys_obstacle *obs = *ent.pobsit.value();
+    segs.clear();
+    if (not obs->get_segments(segs))
+      continue;
+
+    for (const line_segment &seg : segs)
+      m_static_segments.add(seg, obs);
+    ent.flags |= oflag::is_indexed;
+    m_physics->remove_obstacle(obs);
+  }
+  m_static_segments.build();
 }
 
 const mw::grid<bool>&
@@ -184,6 +232,8 @@ mw::area_map::add_static_object(object *obj) noexcept
   const object_id id = --m_objects.end();
   id.get()->flags |= oflag::is_static;
   _put_on_vicinity_grid(id, true);
+  m_static_tiles.clear();
+  m_static_version += 1;
   return id;
 }
 
@@ -200,6 +250,16 @@ mw::area_map::register_phys_object(object_id it)
   }
   m_phys_objects.push_back(obs);
   ent.pobjit = --m_phys_objects.cend();
+
+  // phys-objects take precedence over phys-obstacles
+  m_physics->add_object(obs);
+  // objects spawned in the middle of a tick can be found by physics
+  if (not (ent.flags & oflag::is_static))
+    _put_phys_object_on_vicinity_grid(it);
+  if (ent.flags & oflag::is_indexed)
+    _index_static_segments();
+  else if (ent.pobsit.has_value())
+    m_physics->remove_obstacle(*ent.pobsit.value());
 }
 
 void
@@ -215,6 +275,9 @@ mw::area_map::register_phys_obstacle(object_id it)
   }
   m_phys_obstacles.push_back(obs);
   ent.pobsit = --m_phys_obstacles.cend();
+
+  if (not ent.pobjit.has_value())
+    m_physics->add_obstacle(obs);
 }
 
 void
@@ -230,6 +293,10 @@ mw::area_map::register_vis_obstacle(object_id it)
   }
   m_vis_obstacles.push_back(obs);
   ent.vobsit = --m_vis_obstacles.cend();
+
+  // only phys-obstacles can be put on the vicinity grid
+  if (dynamic_cast<phys_obstacle*>(ent.objptr) == nullptr)
+    m_off_grid_vis_obstacles.push_back(obs);
 }
 
 void
@@ -280,50 +347,112 @@ mw::area_map::draw() const noexcept
 }
 
 void
-mw::area_map::tick(physics_processor &physproc, int msec)
+mw::area_map::set_physics(std::unique_ptr<physics_processor> physproc)
 {
-  for (auto it = m_objects.begin(); it != m_objects.end(); ++it)
+  m_physics = std::move(physproc);
+  for (const object_entry &ent : m_objects)
   {
-    object* obj = it->objptr;
-    if (it->pobjit.has_value())
-      physproc.add_object(const_cast<phys_object*>(*it->pobjit.value()));
-    else if (it->pobsit.has_value())
-      physproc.add_obstacle(const_cast<phys_obstacle*>(*it->pobsit.value()));
+    if (ent.pobjit.has_value())
+      m_physics->add_object(*ent.pobjit.value());
+    else if (ent.pobsit.has_value() and not (ent.flags & oflag::is_indexed))
+      m_physics->add_obstacle(*ent.pobsit.value());
   }
+}
 
-  physproc.process(*this);
+void
+mw::area_map::tick(int msec)
+{
+  for (phys_object *obj : m_phys_objects)
+    obj->begin_step();
+  m_physics->process(*this, msec);
 
+  // drop objects gone by now so that nobody sees them
+  bool reindex = false;
   for (auto it = m_objects.begin(); it != m_objects.end();)
   {
-    object* obj = it->objptr;
-    if (obj->is_gone())
-    {
-      auto tmp = it;
+    if (it->objptr->is_gone())
+      reindex |= _erase_object(it++);
+    else
       ++it;
+  }
 
-      if (tmp->pobjit.has_value())
-        m_phys_objects.erase(tmp->pobjit.value());
-      if (tmp->pobsit.has_value())
-        m_phys_obstacles.erase(tmp->pobsit.value());
-      if (tmp->vobsit.has_value())
-        m_vis_obstacles.erase(tmp->vobsit.value());
+  // process vision of all objects at once
+  for (const object_entry &ent : m_objects)
+    ent.objptr->request_vision(*this, m_vision_service, msec);
+  m_vision_service.run(*this);
 
-      m_objects.erase(tmp);
-      delete obj;
+  for (auto it = m_objects.begin(); it != m_objects.end();)
+  {
+    object* obj = it->objptr;
+    if (obj->is_gone())
+    {
+      reindex |= _erase_object(it++);
       continue;
     }
 
     obj->update(*this, msec);
     ++it;
   }
+
+  // drop segments of deleted obstacles
+  if (reindex)
+    _index_static_segments();
+
+  // don't leave identifiers of deleted objects on the grid
+  update_vicinity_grid();
+}
+
+bool
+mw::area_map::_erase_object(object_iterator it)
+{
+  bool reindex = false;
+  object *obj = it->objptr;
+
+  if (it->flags & oflag::is_static)
+  {
+    m_static_tiles.clear();
+    m_static_version += 1;
+  }
+
+  if (it->pobjit.has_value())
+    m_physics->remove_object(*it->pobjit.value());
+  else if (it->flags & oflag::is_indexed)
+    reindex = true;
+  else if (it->pobsit.has_value())
+    m_physics->remove_obstacle(*it->pobsit.value());
+
+  if (it->pobjit.has_value())
+  {
+    m_grid_footprints.erase(*it->pobjit.value());
+    m_phys_objects.erase(it->pobjit.value());
+  }
+  if (it->pobsit.has_value())
+    m_phys_obstacles.erase(it->pobsit.value());
+  if (it->vobsit.has_value())
+  {
+    const vis_obstacle *vobs = *it->vobsit.value();
+    m_vis_obstacles.erase(it->vobsit.value());
+    const auto offgridit = std::find(m_off_grid_vis_obstacles.begin(),
+        m_off_grid_vis_obstacles.end(), vobs);
+    if (offgridit != m_off_grid_vis_obstacles.end())
+      m_off_grid_vis_obstacles.erase(offgridit);
+  }
+
+  m_objects.erase(it);
+  delete obj;
+  return reindex;
 }
 
 void
 mw::area_map::draw_all() const
 {
-  SDL_Renderer *rend = m_sdl.get_renderer();
+  _draw_static_tiles(true);
   for (const auto &ent : m_objects)
-    ent.objptr->draw(*this);
+  {
+    if ((ent.flags & oflag::is_static) == 0)
+      ent.objptr->draw(*this);
+  }
+  _draw_lights();
 }
 
 void
@@ -340,6 +469,7 @@ mw::area_map::draw_visible(const vision_processor &local_vision,
     if (not ent.vobsit.has_value())
       ent.objptr->draw(*this);
   }
+  _draw_lights();
 
   // draw obstacles within local vision
   for (const sight &s : local_vision.get_sights())
@@ -349,11 +479,126 @@ mw::area_map::draw_visible(const vision_processor &local_vision,
 }
 
 void
-mw::area_map::draw_obstacles() const
+mw::area_map::draw_static_obstacles() const
+{
+  for (const auto &ent : m_objects)
+  {
+    if ((ent.flags & oflag::is_static) and ent.pobsit.has_value())
+      ent.objptr->draw(*this);
+  }
+}
+
+void
+mw::area_map::draw_dynamic_obstacles() const
+{
+  for (const auto &ent : m_objects)
+  {
+    if ((ent.flags & oflag::is_static) == 0 and ent.pobsit.has_value() and
+        not ent.pobjit.has_value())
+      ent.objptr->draw(*this);
+  }
+}
+
+void
+mw::area_map::draw_markers(int radius, color_t color,
+    const phys_object *ignore) const
 {
   SDL_Renderer *rend = m_sdl.get_renderer();
-  for (const phys_obstacle *obs : m_phys_obstacles)
-    obs->draw(*this);
+  for (const auto &ent : m_objects)
+  {
+    if (not ent.pobjit.has_value() or not ent.pobsit.has_value())
+      continue;
+    const phys_object *obj = *ent.pobjit.value();
+    if (obj == ignore)
+      continue;
+    const pt2d_d pos = obj->get_interpolated_position(m_interpolation);
+    const pt2d_i pix = point_to_pixels(pos);
+    filledCircleColor(rend, pix.x, pix.y, radius, color);
+  }
+}
+
+void
+mw::area_map::_draw_static_tiles(bool frame) const
+{
+  SDL_Renderer *rend = m_sdl.get_renderer();
+  if (frame)
+    m_static_tiles.next_frame();
+
+  const int level = tile_cache::get_level(m_scale);
+  const double tilescale = tile_cache::get_level_scale(level);
+  const double tilew = tile_cache::tile_size / tilescale;
+
+  // tiles covering both the screen and the map
+  int winw, winh;
+  SDL_GetWindowSize(m_sdl.get_window(), &winw, &winh);
+  const mapping view = get_view();
+  const pt2d_d ul = view.inverse()(pt2d_d {0, 0});
+  const pt2d_d dr = view.inverse()(pt2d_d {double(winw), double(winh)});
+  const int ix1 = std::max(0., std::floor(ul.x / tilew));
+  const int iy1 = std::max(0., std::floor(ul.y / tilew));
+  const int ix2 = std::min(std::floor(dr.x / tilew), std::floor(m_width / tilew));
+  const int iy2 = std::min(std::floor(dr.y / tilew), std::floor(m_height / tilew));
+
+  // tiles are drawn with premultiplied colors (see _render_static_tile())
+  const SDL_BlendMode premulblend = premultiplied_blend_mode();
+
+  for (int iy = iy1; iy <= iy2; ++iy)
+  {
+    for (int ix = ix1; ix <= ix2; ++ix)
+    {
+      bool isnew;
+      SDL_Texture *tex = m_static_tiles.get(level, ix, iy, isnew);
+      if (isnew)
+        _render_static_tile(tex, tilescale, ix, iy);
+
+      // neighbouring tiles must share their edges
+      const pt2d_d p1 = view(pt2d_d {ix*tilew, iy*tilew});
+      const pt2d_d p2 = view(pt2d_d {(ix + 1)*tilew, (iy + 1)*tilew});
+      SDL_Rect dst;
+      dst.x = std::floor(p1.x);
+      dst.y = std::floor(p1.y);
+      dst.w = int(std::floor(p2.x)) - dst.x;
+      dst.h = int(std::floor(p2.y)) - dst.y;
+      SDL_SetTextureBlendMode(tex, premulblend);
+      SDL_RenderCopy(rend, tex, nullptr, &dst); // TODO handle errors
+    }
+  }
+}
+
+void
+mw::area_map::_render_static_tile(SDL_Texture *tex, double scale, int ix,
+    int iy) const
+{
+  SDL_Renderer *rend = m_sdl.get_renderer();
+  const double tilew = tile_cache::tile_size / scale;
+  const pt2d_d origin = {ix*tilew, iy*tilew};
+
+  SDL_Texture *oldtarget = get_render_target(rend);
+  set_render_target(rend, tex);
+  SDL_SetRenderDrawColor(rend, 0x00, 0x00, 0x00, 0x00);
+  SDL_RenderClear(rend);
+
+  // objects draw themselves using the view of the map; lines are blended over
+  // transparent pixels, so resulting colors are premultiplied by alpha
+  const mapping oldview = get_view();
+  _switch_view({{-origin.x*scale, -origin.y*scale}, scale, scale});
+  const double margin = 2/scale;
+  const rectangle box = {
+    origin - vec2d_d(margin, margin),
+    tilew + 2*margin, tilew + 2*margin
+  };
+  for (const auto &ent : m_objects)
+  {
+    if ((ent.flags & oflag::is_static) == 0)
+      continue;
+    if (ent.pobsit.has_value() and
+        not (*ent.pobsit.value())->overlap_box(box))
+      continue;
+    ent.objptr->draw(*this);
+  }
+  _switch_view(oldview);
+
+  set_render_target(rend, oldtarget);
 }
 
 //SDL_Texture*
@@ -392,26 +637,35 @@ mw::area_map::draw_messages() const
 void
 mw::area_map::blit_glow_with_shadowcast(SDL_Texture *tex,
     const rectangle &dstbox, uint8_t alpha, int flags,
-    vision_processor &localvision) const
+    vision_processor &visproc) const
+{
+  if (m_deferred_lighting)
+  {
+    m_lights.push_back({tex, dstbox, alpha, flags, visproc.get_ignore()});
+    return;
+  }
+  _blit_glow(tex, dstbox, alpha, flags, visproc);
+}
+
+void
+mw::area_map::_blit_glow(SDL_Texture *tex, const rectangle &dstbox,
+    uint8_t alpha, int flags, vision_processor &localvision) const
 {
   SDL_Renderer *rend = m_sdl.get_renderer();
   if (not m_bgtex)
     abort();
 
-  uint32_t format;
-  int access, w, h;
   const int pixw = dstbox.width * m_scale;
   const int pixh = dstbox.height * m_scale;
 
-  //SDL_QueryTexture(tex, &format, &access, &w, &h);
-
-  // create new texture, we will draw on it
-  SDL_Texture *canvas = create_texture(rend, SDL_TEXTUREACCESS_TARGET, pixw, pixh);
+  // take a texture to draw on (only its top-left pixw x pixh part is used)
+  SDL_Texture *canvas = m_render_targets.acquire(pixw, pixh);
+  const SDL_Rect canvasrect = {0, 0, pixw, pixh};
   SDL_Texture *oldtarget = get_render_target(rend);
   set_render_target(rend, canvas);
 
   // maps between map-CS and canvas-CS
-  SDL_QueryTexture(canvas, &format, &access, &w, &h);
+  const int w = pixw, h = pixh;
   const mapping map_to_screen {{m_x_offs, m_y_offs}, m_scale, m_scale};
   const rectangle pixbox = map_to_screen(dstbox);
   const mapping tex_to_screen {to_vec(pixbox.offset), pixbox.width/w, pixbox.height/h};
@@ -421,7 +675,7 @@ mw::area_map::blit_glow_with_shadowcast(SDL_Texture *tex,
   // draw glow-texture
   SDL_SetTextureAlphaMod(tex, alpha);
   SDL_SetTextureBlendMode(tex, SDL_BLENDMODE_NONE);
-  SDL_RenderCopy(rend, tex, nullptr, nullptr); // TODO handle errors
+  SDL_RenderCopy(rend, tex, nullptr, &canvasrect); // TODO handle errors
 
   // draw bakcground
   SDL_Rect bgtexrect = m_world_to_bgtex(dstbox);
@@ -482,13 +736,14 @@ mw::area_map::blit_glow_with_shadowcast(SDL_Texture *tex,
     dstbox.offset + vec2d_d(dstbox.width, dstbox.height)/2;
   const double visradius = std::max(dstbox.width, dstbox.height)/2;
   localvision.set_source({viscenter, visradius});
-  localvision.load_obstacles(m_vis_obstacles);
+  localvision.load_obstacles(*this);
   localvision.process();
   localvision.shadowcast(rend, dstbox, SDL_BLENDMODE_NONE, 0x00000000, map_to_tex);
 
   // apply effects due to global vision
-  vision_processor::sight_container localsights {localvision.get_sights().begin(),
-                                                 localvision.get_sights().end()};
+  vision_processor::sight_container &localsights = m_glow_sights;
+  localsights.assign(localvision.get_sights().begin(),
+      localvision.get_sights().end());
   if (flags & blit_flags::apply_global_vision and m_global_vision.has_value())
   {
     m_global_vision
@@ -507,10 +762,10 @@ mw::area_map::blit_glow_with_shadowcast(SDL_Texture *tex,
   dst.w = pixbox.width;
   dst.h = pixbox.height;
   SDL_SetTextureBlendMode(canvas, SDL_BLENDMODE_BLEND);
-  SDL_RenderCopy(rend, canvas, nullptr, &dst);
+  SDL_RenderCopy(rend, canvas, &canvasrect, &dst);
 
-  // destroy texture
-  SDL_DestroyTexture(canvas);
+  // return texture to the pool
+  m_render_targets.release(canvas);
 
   // drow locally visible objects
   if (flags & blit_flags::draw_sights)
@@ -524,8 +779,200 @@ void
 mw::area_map::blit_glow_with_shadowcast(SDL_Texture *tex,
     const rectangle &dstbox, uint8_t alpha, int flags) const
 {
-  vision_processor visproc;
-  blit_glow_with_shadowcast(tex, dstbox, alpha, flags, visproc);
+  m_glow_vision.reset();
+  blit_glow_with_shadowcast(tex, dstbox, alpha, flags, m_glow_vision);
+}
+
+void
+mw::area_map::_draw_lights() const
+{
+  if (m_lights.empty())
+    return;
+
+  SDL_Renderer *rend = m_sdl.get_renderer();
+  if (not m_bgtex)
+    abort();
+
+  int winw, winh;
+  SDL_GetWindowSize(m_sdl.get_window(), &winw, &winh);
+  const int lightw = std::max(1, int(winw * m_light_resolution));
+  const int lighth = std::max(1, int(winh * m_light_resolution));
+  const double kx = double(lightw)/winw;
+  const double ky = double(lighth)/winh;
+  const mapping map_to_light {{m_x_offs*kx, m_y_offs*ky}, m_scale*kx,
+    m_scale*ky};
+
+  // take a texture to accumulate the light (only top-left lightw x lighth
+  // part is used)
+  SDL_Texture *lightmap = m_render_targets.acquire(lightw, lighth);
+  const SDL_Rect lightrect = {0, 0, lightw, lighth};
+  SDL_Texture *oldtarget = get_render_target(rend);
+  set_render_target(rend, lightmap);
+  SDL_SetRenderDrawColor(rend, 0x00, 0x00, 0x00, 0x00);
+  SDL_RenderClear(rend);
+
+  // glows obscured by the global vision go first, so that its shadows can be
+  // cast over all of them at once
+  std::stable_sort(m_lights.begin(), m_lights.end(),
+      [] (const light &a, const light &b) { return a.tex < b.tex; });
+  m_glow_sights.clear();
+  bool ok = _add_lights(true, map_to_light);
+  if (ok and m_global_vision.has_value())
+  {
+    const rectangle screenbox =
+      map_to_light.inverse()(rectangle {{0, 0}, double(lightw), double(lighth)});
+    m_global_vision
+      .value()
+      .shadowcast(rend, screenbox, SDL_BLENDMODE_NONE, 0x00000000, map_to_light);
+  }
+  ok = ok and _add_lights(false, map_to_light);
+  if (not ok)
+  {
+    // drop the light map and blit glows one by one from now on
+    set_render_target(rend, oldtarget);
+    m_render_targets.release(lightmap);
+    m_deferred_lighting = false;
+    for (const light &l : m_lights)
+    {
+      m_glow_vision.reset();
+      m_glow_vision.set_ignore(l.ignore);
+      _blit_glow(l.tex, l.box, l.alpha, l.flags, m_glow_vision);
+    }
+    m_lights.clear();
+    return;
+  }
+
+  // light up the background: add it scaled by accumulated alpha
+  const rectangle mapbox = {{0, 0}, m_width, m_height};
+  const SDL_Rect bgsrcrect = m_world_to_bgtex(mapbox);
+  const SDL_Rect bgdstrect = map_to_light(mapbox);
+  SDL_SetTextureBlendMode(m_bgtex, lit_blend_mode());
+  if (SDL_RenderCopy(rend, m_bgtex, &bgsrcrect, &bgdstrect) < 0)
+    warning("failed to light up the background (%s)", SDL_GetError());
+  set_render_target(rend, oldtarget);
+
+  // composite the light map (its colors are premultiplied by alpha)
+  SDL_SetTextureBlendMode(lightmap, premultiplied_color_blend_mode());
+  SDL_SetTextureScaleMode(lightmap, SDL_ScaleModeLinear);
+  if (SDL_RenderCopy(rend, lightmap, &lightrect, nullptr) < 0)
+    warning("failed to composite the light map (%s)", SDL_GetError());
+  m_render_targets.release(lightmap);
+
+  // drow locally visible objects
+  for (const sight &s : m_glow_sights)
+    s.static_data.obs->draw(*this, s);
+
+  m_lights.clear();
+}
+
+bool
+mw::area_map::_add_lights(bool global, const mapping &map_to_light) const
+{
+  SDL_Renderer *rend = m_sdl.get_renderer();
+
+  // glows sharing a texture are drawn together
+  SDL_Texture *curtex = nullptr;
+  bool ok = true;
+  const auto flush = [&] () {
+    if (curtex and not m_light_indices.empty())
+    {
+      SDL_SetTextureBlendMode(curtex, light_blend_mode());
+      if (SDL_RenderGeometry(rend, curtex, m_light_vertices.data(),
+            m_light_vertices.size(), m_light_indices.data(),
+            m_light_indices.size()) < 0)
+      {
+        warning("failed to render light geometry (%s), falling back to "
+            "separate glows", SDL_GetError());
+        ok = false;
+      }
+    }
+    m_light_vertices.clear();
+    m_light_indices.clear();
+  };
+
+  vision_processor &visproc = m_glow_vision;
+  for (const light &l : m_lights)
+  {
+    if (bool(l.flags & blit_flags::apply_global_vision) != global)
+      continue;
+    if (l.tex != curtex)
+    {
+      flush();
+      if (not ok)
+        return false;
+      curtex = l.tex;
+    }
+
+    // visible area within the box (edges of the box enclose it)
+    const pt2d_d center = l.box.offset + vec2d_d(l.box.width, l.box.height)/2;
+    const double radius = 0.51 * std::hypot(l.box.width, l.box.height);
+    visproc.reset();
+    visproc.set_source({center, radius});
+    visproc.set_ignore(l.ignore);
+    visproc.load_obstacles(*this);
+    sight edges[4];
+    size_t nedges = 0;
+    for (int i = 0; i < 4; ++i)
+    {
+      line_segment edge;
+      box_edge(l.box, i, edge);
+      if (cast_sight(visproc.get_source(), edge, edges[nedges]))
+      {
+        edges[nedges].static_data.obs = nullptr;
+        edges[nedges].static_data.aux_data = i;
+        nedges += 1;
+      }
+    }
+    visproc.load_sights(edges, edges + nedges);
+    visproc.process();
+
+    // fan of triangles from the center to visible parts of sights
+    SDL_Vertex vert;
+    vert.color = {0xFF, 0xFF, 0xFF, l.alpha};
+    const auto add_vertex = [&] (const pt2d_d &p) {
+      const pt2d_d q = map_to_light(p);
+      vert.position = {float(q.x), float(q.y)};
+      vert.tex_coord = {
+        float((p.x - l.box.offset.x) / l.box.width),
+        float((p.y - l.box.offset.y) / l.box.height)
+      };
+      m_light_vertices.push_back(vert);
+    };
+    const int icenter = m_light_vertices.size();
+    add_vertex(center);
+    m_lit_sights.clear();
+    for (const sight &s : visproc.get_sights())
+    {
+      const int i = m_light_vertices.size();
+      if (s.tag == sight::line)
+      {
+        add_vertex(s.static_data.line(s.sight_data.line.t1));
+        add_vertex(s.static_data.line(s.sight_data.line.t2));
+      }
+      else
+      {
+        add_vertex(s.static_data.circle(s.sight_data.circle.cphi1));
+        add_vertex(s.static_data.circle(s.sight_data.circle.cphi2));
+      }
+      m_light_indices.push_back(icenter);
+      m_light_indices.push_back(i);
+      m_light_indices.push_back(i + 1);
+
+      if (s.static_data.obs and l.flags & blit_flags::draw_sights)
+        m_lit_sights.push_back(s);
+    }
+
+    // objects lit by the glow
+    if (global and m_global_vision.has_value())
+    {
+      const bool foreignsource = center != m_global_vision->get_source().center;
+      m_global_vision.value().apply(foreignsource, m_lit_sights);
+    }
+    m_glow_sights.insert(m_glow_sights.end(), m_lit_sights.begin(),
+        m_lit_sights.end());
+  }
+  flush();
+  return ok;
 }
 
 void
@@ -578,6 +1025,187 @@ mw::area_map::dump() const
   });
 }
 
+void
+mw::area_map::update_vicinity_grid()
+{
+  m_vicinity_grid.tick();
+  m_grid_stamp += 1;
+  for (auto it = m_objects.begin(); it != m_objects.end(); ++it)
+  {
+    if ((it->flags & oflag::is_static) or it->objptr->is_gone())
+      continue;
+
+    if (it->pobjit.has_value())
+      _put_phys_object_on_vicinity_grid(it);
+    else if (it->pobsit.has_value())
+      _put_on_vicinity_grid(it, false);
+    else if (it->vobsit.has_value() and
+             dynamic_cast<const phys_obstacle*>(it->objptr))
+      _put_on_vicinity_grid(it, false);
+  }
+}
+
+void
+mw::area_map::move_on_vicinity_grid(const phys_object *obj)
+{
+  const auto it = m_grid_footprints.find(obj);
+  if (it == m_grid_footprints.end() or it->second.stamp != m_grid_stamp)
+    return;
+
+  grid_footprint &fp = it->second;
+  size_t ix0, iy0, ix1, iy1;
+  _get_vicinity_cells(obj, ix0, iy0, ix1, iy1);
+  if (ix0 == fp.ix0 and iy0 == fp.iy0 and ix1 == fp.ix1 and iy1 == fp.iy1)
+    return;
+
+  const auto inside = [] (size_t ix, size_t iy, size_t ix0, size_t iy0,
+      size_t ix1, size_t iy1) {
+    return ix0 <= ix and ix <= ix1 and iy0 <= iy and iy <= iy1;
+  };
+  const object_iterator objit = fp.id.get();
+  for (size_t ix = fp.ix0; ix <= fp.ix1; ++ix)
+  {
+    for (size_t iy = fp.iy0; iy <= fp.iy1; ++iy)
+    {
+      if (not inside(ix, iy, ix0, iy0, ix1, iy1))
+      {
+        m_vicinity_grid.remove_if(ix, iy, [&] (const object_id &id) {
+          return id.get() == objit;
+        });
+      }
+    }
+  }
+  for (size_t ix = ix0; ix <= ix1; ++ix)
+  {
+    for (size_t iy = iy0; iy <= iy1; ++iy)
+    {
+      if (not inside(ix, iy, fp.ix0, fp.iy0, fp.ix1, fp.iy1))
+        m_vicinity_grid.put(ix, iy, fp.id);
+    }
+  }
+  fp.ix0 = ix0;
+  fp.iy0 = iy0;
+  fp.ix1 = ix1;
+  fp.iy1 = iy1;
+}
+
+void
+mw::area_map::collect_vis_obstacles(const circle &circ,
+    vis_obstacle_list &out) const
+{
+  out.clear();
+
+  // whole map is covered: no use in scanning the grid
+  const double r2 = circ.radius*circ.radius;
+  const bool covers_map =
+    mag2(circ.center - pt2d_d {0, 0}) <= r2 and
+    mag2(circ.center - pt2d_d {m_width, 0}) <= r2 and
+    mag2(circ.center - pt2d_d {0, m_height}) <= r2 and
+    mag2(circ.center - pt2d_d {m_width, m_height}) <= r2;
+  if (covers_map)
+  {
+    out.assign(m_vis_obstacles.begin(), m_vis_obstacles.end());
+    return;
+  }
+
+  scan_vicinity(circ, [&] (const object_id &id) {
+    if (is_vis_obstacle(id))
+      out.push_back(as_vis_obstacle(id));
+  });
+  std::sort(out.begin(), out.end());
+  out.erase(std::unique(out.begin(), out.end()), out.end());
+  out.insert(out.end(), m_off_grid_vis_obstacles.begin(),
+      m_off_grid_vis_obstacles.end());
+}
+
+bool
+mw::area_map::has_line_of_sight(const pt2d_d &from, const pt2d_d &to,
+    std::initializer_list<const vis_obstacle*> ignore) const
+{
+  const line_segment ray {from, to - from};
+  vis_obstacle_list &obstacles = m_los_obstacles;
+  collect_vis_obstacles({from + ray.direction*0.5, mag(ray.direction)*0.5},
+      obstacles);
+  for (const vis_obstacle *obs : obstacles)
+  {
+    if (std::find(ignore.begin(), ignore.end(), obs) != ignore.end())
+      continue;
+    if (obs->obscures(ray))
+      return false;
+  }
+  return true;
+}
+
+bool
+mw::area_map::has_line_of_sight(const pt2d_d &from, const circle &to,
+    std::initializer_list<const vis_obstacle*> ignore) const
+{
+  const vec2d_d d = to.center - from;
+  const double l = mag(d);
+  if (l <= to.radius)
+    return true;
+
+  // center and tangent points
+  const double t = sqrt(l*l - to.radius*to.radius);
+  const double c = t/l, s = to.radius/l;
+  const vec2d_d u = d/l;
+  const pt2d_d targets[] = {
+    to.center,
+    from + vec2d_d {u.x*c - u.y*s, u.y*c + u.x*s}*t,
+    from + vec2d_d {u.x*c + u.y*s, u.y*c - u.x*s}*t,
+  };
+
+  vis_obstacle_list &obstacles = m_los_obstacles;
+  collect_vis_obstacles({from + d*0.5, l*0.5 + to.radius}, obstacles);
+  for (const pt2d_d &target : targets)
+  {
+    const line_segment ray {from, target - from};
+    const bool blocked = std::any_of(obstacles.begin(), obstacles.end(),
+        [&] (const vis_obstacle *obs) {
+      return std::find(ignore.begin(), ignore.end(), obs) == ignore.end()
+         and obs->obscures(ray);
+    });
+    if (not blocked)
+      return true;
+  }
+  return false;
+}
+
+void
+mw::area_map::_get_vicinity_cells(const phys_object *obj, size_t &ix0,
+    size_t &iy0, size_t &ix1, size_t &iy1) const noexcept
+{
+  const auto [nx, ny] = m_vicinity_grid.get_dimentions();
+  const double cw = m_width / nx;
+  const double ch = m_height / ny;
+
+  // clamp to the grid (objects may get outside the map)
+  const auto cellidx = [] (double x, size_t n) -> size_t {
+    return x <= 0 ? 0 : x >= n ? n - 1 : size_t(x);
+  };
+  const pt2d_d p = obj->get_position();
+  const double r = obj->get_radius();
+  ix0 = cellidx(std::floor((p.x - r) / cw), nx);
+  ix1 = cellidx(std::floor((p.x + r) / cw), nx);
+  iy0 = cellidx(std::floor((p.y - r) / ch), ny);
+  iy1 = cellidx(std::floor((p.y + r) / ch), ny);
+}
+
+void
+mw::area_map::_put_phys_object_on_vicinity_grid(const object_id &id)
+{
+  const phys_object *obj = *id.get()->pobjit.value();
+  grid_footprint &fp = m_grid_footprints[obj];
+  fp.id = id;
+  fp.stamp = m_grid_stamp;
+  _get_vicinity_cells(obj, fp.ix0, fp.iy0, fp.ix1, fp.iy1);
+  for (size_t ix = fp.ix0; ix <= fp.ix1; ++ix)
+  {
+    for (size_t iy = fp.iy0; iy <= fp.iy1; ++iy)
+      m_vicinity_grid.put(ix, iy, id);
+  }
+}
+
 void
 mw::area_map::_put_on_vicinity_grid(const object_id &id, bool is_static)
 {
@@ -601,10 +1229,15 @@ mw::area_map::_put_on_vicinity_grid(const object_id &id, bool is_static)
   std::set<pt2d<size_t>, compare_points> visited_cells;
   std::stack<pt2d<size_t>> stack;
 
+  // clamp to the grid (objects may get outside the map)
+  const auto cellidx = [] (double x, size_t n) -> size_t {
+    return x <= 0 ? 0 : x >= n ? n - 1 : size_t(x);
+  };
   const pt2d_d pt = pobs->sample_point();
-  const size_t ix0 = std::floor(pt.x / cw);
-  const size_t iy0 = std::floor(pt.y / ch);
+  const size_t ix0 = cellidx(std::floor(pt.x / cw), nx);
+  const size_t iy0 = cellidx(std::floor(pt.y / ch), ny);
   stack.emplace(ix0, iy0);
+  visited_cells.emplace(ix0, iy0);
   if (is_static)
     m_vicinity_grid.put_static(ix0, iy0, id);
   else
@@ -9,6 +9,14 @@
 #include <boost/format.hpp>
 
 
+mw::game_manager::~game_manager()
+{
+  if (m_minimap_static)
+    SDL_DestroyTexture(m_minimap_static);
+  if (m_minimap)
+    SDL_DestroyTexture(m_minimap);
+}
+
 void
 mw::game_manager::_handle_zoom_keys(const pt2d_i &at, time_t dt)
 {
@@ -129,19 +137,29 @@ mw::game_manager::run_game(boost::optional<ui_manager&> uiman)
     }
   }
 
-  std::chrono::milliseconds nticks;
-  if (m_tick_limiter(nticks))
+  // advance the game in fixed steps; what is left is carried to the next
+  // frame and used to interpolate positions for drawing
+  m_tick_accumulator += dt;
+  for (int i = 0; i < m_max_catchup_ticks and m_tick_accumulator >= m_tick_size;
+       ++i)
   {
-    md_physics physproc {double(nticks.count())};
-    m_map.tick(physproc, nticks.count());
+    m_map.tick(m_tick_size);
+    m_tick_accumulator -= m_tick_size;
   }
+  if (m_tick_accumulator >= m_tick_size)
+    m_tick_accumulator %= m_tick_size;
+  m_map.set_interpolation(double(m_tick_accumulator)/m_tick_size);
 
   m_hud.update();
 
   if (fps_guardian(SDL_GetTicks()))
   {
     if (m_player.has_value() and m_center_on_player)
-      m_map.adjust_offset(m_player.value().get_position(), {winw/2, winh/2});
+    {
+      const pt2d_d playerpos = m_player.value().get_interpolated_position(
+          m_map.get_interpolation());
+      m_map.adjust_offset(playerpos, {winw/2, winh/2});
+    }
 
     if (uiman.has_value())
       uiman.value().draw(get_id());
@@ -168,18 +186,20 @@ mw::game_manager::draw() const
     {
       SDL_Renderer *rend = m_sdl.get_renderer();
 
-      const pt2d_d playerpos = m_player.value().get_position();
+      // shadows must follow the player as drawn
+      const pt2d_d playerpos = m_player.value().get_interpolated_position(
+          m_map.get_interpolation());
 
-      vision_processor localvision {{playerpos, m_player_vision_radius}};
+      vision_processor &localvision = m_local_vision;
+      localvision.reset();
+      localvision.set_source({playerpos, m_player_vision_radius});
       localvision.set_ignore(&m_player.value());
-      localvision.load_obstacles(m_map.get_vis_obstacles());
+      localvision.load_obstacles(m_map);
       localvision.process();
 
       const double globalvisradius = std::max(m_map.get_width(), m_map.get_height());
-      vision_processor globalvision {{playerpos, globalvisradius}};
-      globalvision.set_ignore(&m_player.value());
-      globalvision.load_obstacles(m_map.get_vis_obstacles());
-      globalvision.process();
+      const vision_processor &globalvision = m_global_vision.update(m_map,
+          {playerpos, globalvisradius}, &m_player.value());
 
       m_map.draw_visible(localvision, globalvision);
     }
@@ -191,20 +211,87 @@ mw::game_manager::draw() const
 
   m_map.draw_messages();
 
-  // minimap
+  _draw_minimap();
+
+  // GUI
+  m_hud_footprint.clear();
+  m_hud.draw(m_hud_footprint);
+}
+
+void
+mw::game_manager::_draw_minimap() const
+{
+  SDL_Renderer *rend = m_sdl.get_renderer();
+
   int winw, winh;
   SDL_GetWindowSize(m_sdl.get_window(), &winw, &winh);
   const double w2h_ratio = m_map.get_width()/m_map.get_height();
   const int miniw = winw*0.2;
   const int minih = miniw/w2h_ratio;
   const pt2d_i minipos {winw - miniw - 1, winh - minih -1};
+
+  if (m_minimap == nullptr or miniw != m_minimap_w or minih != m_minimap_h)
+  {
+    if (m_minimap_static)
+      SDL_DestroyTexture(m_minimap_static);
+    if (m_minimap)
+      SDL_DestroyTexture(m_minimap);
+    m_minimap_static = m_minimap = nullptr;
+    m_minimap_static = create_texture(rend, SDL_TEXTUREACCESS_TARGET, miniw,
+        minih);
+    m_minimap = create_texture(rend, SDL_TEXTUREACCESS_TARGET, miniw, minih);
+    m_minimap_w = miniw;
+    m_minimap_h = minih;
+    m_minimap_version = std::nullopt;
+  }
+
+  const uint32_t now = SDL_GetTicks();
+  const bool static_changed =
+    m_minimap_version != m_map.get_static_version();
+  const bool due =
+    not m_minimap_time.has_value() or
+    now - m_minimap_time.value() >= uint32_t(m_minimap_period);
+  if (static_changed or due)
+  {
+    const mapping oldview = m_map.get_view();
+    SDL_Texture *oldtarget = get_render_target(rend);
+    m_map.adjust_to_box_w({0, 0}, miniw);
+
+    // colors are premultiplied as everything is drawn over transparent pixels
+    if (static_changed)
+    {
+      set_render_target(rend, m_minimap_static);
+      SDL_SetRenderDrawColor(rend, 0x00, 0x00, 0x00, 0x00);
+      SDL_RenderClear(rend);
+      m_map.draw_static_obstacles();
+      m_minimap_version = m_map.get_static_version();
+    }
+
+    set_render_target(rend, m_minimap);
+    SDL_SetTextureBlendMode(m_minimap_static, SDL_BLENDMODE_NONE);
+    SDL_RenderCopy(rend, m_minimap_static, nullptr, nullptr);
+    m_map.draw_dynamic_obstacles();
+    m_minimap_time = now;
+
+    set_render_target(rend, oldtarget);
+    m_map.set_view(oldview);
+  }
+
+  const SDL_Rect dst = {minipos.x, minipos.y, miniw, minih};
+  SDL_SetTextureBlendMode(m_minimap, premultiplied_blend_mode());
+  SDL_RenderCopy(rend, m_minimap, nullptr, &dst);
+
+  // markers of characters move every frame
   const mapping oldview = m_map.get_view();
   m_map.adjust_to_box_w(minipos, miniw);
-  m_map.draw_obstacles();
+  m_map.draw_markers(2, 0xFF0000FF, m_player.get_ptr());
+  if (m_player.has_value())
+  {
+    const pt2d_d playerpos = m_player.value().get_interpolated_position(
+        m_map.get_interpolation());
+    const pt2d_i pix = m_map.point_to_pixels(playerpos);
+    filledCircleColor(rend, pix.x, pix.y, 2, 0xFF00FF00);
+  }
   m_map.set_view(oldview);
-
-  // GUI
-  m_hud_footprint.clear();
-  m_hud.draw(m_hud_footprint);
 }
 
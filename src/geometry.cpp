@@ -709,3 +709,48 @@ mw::overlap_box_linesegm(const rectangle &r, const line_segment &l)
   }
   return false;
 }
+
+bool
+mw::sweep_tunnel_linesegm(const tunnel &p, const line_segment &l, double &t,
+    vec2d_d &n)
+{
+  const double d2 = mag2(l.direction);
+  const double r2 = p.radius*p.radius;
+  const auto closest_point = [&] (const pt2d_d &c) -> pt2d_d {
+    if (d2 == 0)
+      return l.origin;
+    const double alpha = dot(c - l.origin, l.direction)/d2;
+    return l(std::max(0., std::min(1., alpha)));
+  };
+
+  // resting contact
+  if (mag2(p.origin - closest_point(p.origin)) < r2)
+    return false;
+
+  double tmin = DBL_MAX, tcur;
+  // side of the segment
+  if (d2 > 0 and intersect(p, l, tcur, ignore_ends {}))
+    tmin = tcur;
+  // ends of the segment
+  if (p.radius > 0)
+  {
+    for (const pt2d_d &end : {l.origin, l.origin + l.direction})
+    {
+      if (intersect(p, end, tcur) > 0 and tcur < tmin)
+        tmin = tcur;
+    }
+  }
+  if (tmin == DBL_MAX)
+    return false;
+
+  t = tmin;
+  const pt2d_d c = p.origin + p.translation*t;
+  n = c - closest_point(c);
+  if (mag2(n) == 0)
+  {
+    // point-like circle: use normal of the segment facing the origin
+    n = vec2d_d {-l.direction.y, l.direction.x};
+    n = n * copysign(1., dot(n, p.origin - l.origin));
+  }
+  return true;
+}
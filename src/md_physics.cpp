@@ -1,7 +1,10 @@
 #include "physics.hpp"
 #include "area_map.hpp"
+#include "algorithms/forest.hpp"
 
 #include <sys/time.h>
+#include <algorithm>
+#include <cfloat>
 
 
 static void
@@ -14,18 +17,69 @@ _get_object_movement(const mw::phys_object *obj, mw::atunnel &move)
 }
 
 void
-mw::md_physics::process(area_map &map)
+mw::md_physics::remove_object(phys_object *obj)
 {
+  if (not m_state.contains(obj))
+  {
+    warning("[md_physics] attempt to remove an unknown object");
+    return;
+  }
+
+  const phys_handle h = obj->get_phys_handle();
+  m_objects[h] = m_objects.back();
+  m_objects.pop_back();
+  m_state.remove(h);
+}
+
+void
+mw::md_physics::remove_obstacle(phys_obstacle *obs)
+{
+  const auto it = m_obstacle_index.find(obs);
+  if (it == m_obstacle_index.end())
+  {
+    warning("[md_physics] attempt to remove an unknown obstacle");
+    return;
+  }
+
+  const size_t idx = it->second;
+  m_obstacle_index.erase(it);
+  m_obstacles[idx] = m_obstacles.back();
+  m_obstacles.pop_back();
+  if (idx < m_obstacles.size())
+    m_obstacle_index[m_obstacles[idx]] = idx;
+}
+
+void
+mw::md_physics::process(area_map &map, double tick_size)
+{
+  m_tick_size = tick_size;
+
   timespec start, stop;
   clock_gettime(CLOCK_MONOTONIC, &start);
-  std::vector<obj_dynamics> dyn;
-  const double dt = m_tick_size/10;
-  for (int i = 0; i < 10; ++i)
+  m_state.gather();
+  m_restless.assign(m_objects.size(), false);
+  _plan_substeps(map);
+  // the vicinity grid is refreshed by the map at the end of each tick, and
+  // only the objects which move are relocated on it below
+  for (int i = 0; i < m_schedule.n_substeps; ++i)
   {
-    dyn.clear();
-    _calc_dynamics(map, dyn);
-    _advance_objects(map, dt, dyn);
+    _schedule_substep(i);
+    _calc_dynamics(map);
+    // objects made gone by collisions must not move
+    _dispatch_collisions(map);
+    _advance_objects(map);
+    if (m_broad_phase == broad_phase::vicinity_grid)
+    {
+      for (size_t k = 0; k < m_objects.size(); ++k)
+      {
+        if (m_dt[k] > 0 and not m_objects[k]->is_gone())
+          map.move_on_vicinity_grid(m_objects[k]);
+      }
+    }
+    _dispatch_collisions(map);
+    _wake_touched(map);
   }
+  _update_sleep_states(map);
   clock_gettime(CLOCK_MONOTONIC, &stop);
 
   const double startsec = double(start.tv_sec) + start.tv_nsec*1e-9;
@@ -35,57 +89,598 @@ mw::md_physics::process(area_map &map)
     warning("[md_physics] took %g/%g [sec]", duration, m_tick_size*1e-3);
 }
 
+static int
+_pow2_ceil(int n)
+{
+  int p = 1;
+  while (p < n)
+    p <<= 1;
+  return p;
+}
+
+// Circle covering a given object.
+static mw::circle
+_reach_of(const mw::phys_object *obj)
+{
+  // point-like objects (e.g. bullets) still have to hit their own cell
+  const double minreach = 1e-6;
+  return {obj->get_position(), std::max(obj->get_radius(), minreach)};
+}
+
+// Upper bound of the stiffness (d force/d depth) of contact forces on a circle
+// of radius R: the overlap area grows by at most a chord (2*R) per unit of
+// depth, and wall ends push with stiffness 1/2.
+static double
+_contact_stiffness(double r)
+{ return 2*r + 0.5; }
 
 void
-mw::md_physics::_calc_dynamics(area_map &map, std::vector<obj_dynamics> &dyn)
-  const
+mw::md_physics::_plan_substeps(const area_map &map)
 {
-  dyn.reserve(m_objects.size());
-  for (phys_object *obj : m_objects)
+  int nmax = 1;
+  while (nmax*2 <= m_max_substeps)
+    nmax *= 2;
+
+  // substeps required by each object to move no more then a fraction of the
+  // smallest radius it interacts with per step
+  std::vector<int> nreq (m_objects.size(), 1);
+  std::vector<phys_obstacle*> nearobss;
+  std::vector<phys_object*> nearobjs;
+  int nsubsteps = 1;
+  for (size_t i = 0; i < m_objects.size(); ++i)
   {
-    if (obj->is_gone())
+    const phys_object *obj = m_objects[i];
+    // point-like objects are handled by continuous collision detection
+    if (obj->is_gone() or obj->get_radius() <= 0 or m_tick_size <= 0)
+      continue;
+    // sleeping objects may be woken at any substep
+    if (obj->is_sleeping())
+    {
+      nreq[i] = 0;
       continue;
+    }
+
+    const std::vector<phys_object*> *objs = &m_objects;
+    if (m_broad_phase == broad_phase::vicinity_grid)
+    {
+      _collect_neighbours(map, _reach_of(obj), nearobss, nearobjs);
+      objs = &nearobjs;
+    }
+    double rmin = obj->get_radius();
+    for (const phys_object *obj2 : *objs)
+    {
+      if (obj2 != obj and not obj2->is_gone() and obj2->get_radius() > 0)
+        rmin = std::min(rmin, obj2->get_radius());
+    }
 
-    vec2d_d tot_force = {0, 0};
-    tot_force = tot_force + obj->get_internal_acceleration()*obj->get_mass();
-    tot_force = tot_force - obj->get_friction_coeff()*obj->get_velocity();
+    const double reach = m_courant*rmin;
+    const double v = mag(obj->get_velocity());
+    const double a = mag(obj->get_internal_acceleration())
+                   + obj->get_friction_coeff()/obj->get_mass()*v;
+    double dtmax = m_tick_size;
+    if (v > 0)
+      dtmax = std::min(dtmax, reach/v);
+    if (a > 0)
+      dtmax = std::min(dtmax, sqrt(2*reach/a));
+    dtmax = std::min(dtmax,
+        sqrt(obj->get_mass()/_contact_stiffness(obj->get_radius())));
 
-    // 1) vs obstacles
-    for (phys_obstacle *obs : m_obstacles)
+    const double n = std::min(double(nmax), std::ceil(m_tick_size/dtmax));
+    nreq[i] = _pow2_ceil(int(n));
+    nsubsteps = std::max(nsubsteps, nreq[i]);
+  }
+
+  // slower objects make larger steps
+  int nclasses = 1;
+  while ((1 << (nclasses - 1)) < nsubsteps)
+    nclasses += 1;
+  m_schedule.n_substeps = nsubsteps;
+  m_schedule.substep_size = m_tick_size/nsubsteps;
+  m_schedule.class_sizes.assign(nclasses, 0);
+  m_rate_class.resize(m_objects.size());
+  for (size_t i = 0; i < m_objects.size(); ++i)
+  {
+    if (nreq[i] == 0)
     {
-      if (obs->is_gone())
+      m_rate_class[i] = 0;
+      continue;
+    }
+
+    int k = 0;
+    while ((nreq[i] << (k + 1)) <= nsubsteps)
+      k += 1;
+    m_rate_class[i] = k;
+    if (not m_objects[i]->is_gone())
+      m_schedule.class_sizes[k] += 1;
+  }
+}
+
+void
+mw::md_physics::_schedule_substep(int substep)
+{
+  const double dt = m_schedule.substep_size;
+  m_dt.resize(m_objects.size());
+  for (size_t i = 0; i < m_objects.size(); ++i)
+  {
+    const int stride = 1 << m_rate_class[i];
+    const phys_object *obj = m_objects[i];
+    const bool active =
+      substep % stride == 0 and not obj->is_gone() and not obj->is_sleeping();
+    m_dt[i] = active ? dt*stride : 0;
+  }
+}
+
+
+// Sum of forces exerted on OBJ by given obstacles and objects. Forces exerted
+// by objects along with a collision are recorded in its event, so that they
+// can be revoked if the object turns out to be gone by then.
+mw::vec2d_d
+mw::md_physics::_sum_forces(area_map &map, phys_object *obj,
+    const std::vector<phys_obstacle*> &obstacles,
+    const std::vector<phys_object*> &objects, collision_buffer &collisions)
+{
+  vec2d_d tot_force = {0, 0};
+
+  // 1) vs obstacles
+  for (phys_obstacle *obs : obstacles)
+  {
+    if (obs->is_gone())
+      continue;
+
+    tot_force = tot_force + obs->act_on_object(map, obj);
+  }
+
+  // 2) vs other objects
+  for (phys_object *obj2 : objects)
+  {
+    if (obj2 == obj or obj2->is_gone())
+      continue;
+
+    const size_t ncollisions = collisions.size();
+    const vec2d_d force = obj2->act_on_object(map, obj);
+    tot_force = tot_force + force;
+    for (size_t k = ncollisions; k < collisions.size(); ++k)
+    {
+      if (collisions[k].obj == obj2 and collisions[k].obs == obj)
+        collisions[k].force = force;
+    }
+  }
+
+  return tot_force;
+}
+
+// Collect obstacles and objects sharing vicinity-grid cells with REACH. Each
+// of them is listed once even if it occupies several of the cells. Obstacles
+// and objects unknown to the processor (e.g. walls from the static segment
+// table) are skipped.
+void
+mw::md_physics::_collect_neighbours(const area_map &map, const circle &reach,
+    std::vector<phys_obstacle*> &obstacles,
+    std::vector<phys_object*> &objects) const
+{
+  obstacles.clear();
+  objects.clear();
+  map.scan_vicinity(reach, [&] (const object_id &id) {
+    if (map.is_phys_object(id))
+    {
+      const phys_object *obj = map.as_phys_object(id);
+      if (m_state.contains(obj))
+        objects.push_back(const_cast<phys_object*>(obj));
+    }
+    else if (map.is_phys_obstacle(id))
+    {
+      const phys_obstacle *obs = map.as_phys_obstacle(id);
+      if (m_obstacle_index.count(obs))
+        obstacles.push_back(const_cast<phys_obstacle*>(obs));
+    }
+  });
+
+  // order by indices rather than by addresses to keep the order of summation
+  // independent from the memory layout
+  const auto obsless = [this] (const phys_obstacle *a, const phys_obstacle *b) {
+    return m_obstacle_index.at(a) < m_obstacle_index.at(b);
+  };
+  std::sort(obstacles.begin(), obstacles.end(), obsless);
+  obstacles.erase(std::unique(obstacles.begin(), obstacles.end()),
+      obstacles.end());
+  const auto objless = [] (const phys_object *a, const phys_object *b) {
+    return a->get_phys_handle() < b->get_phys_handle();
+  };
+  std::sort(objects.begin(), objects.end(), objless);
+  objects.erase(std::unique(objects.begin(), objects.end()), objects.end());
+}
+
+void
+mw::md_physics::_calc_dynamics(area_map &map)
+{
+  // internal acceleration and friction
+  m_state.reset_forces();
+
+  // interactions
+  const segment_table &segtab = map.get_static_segments();
+  const auto eval_chunk = [&] (size_t ichunk, size_t begin, size_t end) {
+    collision_buffer_scope _ {m_collisions[ichunk]};
+    std::vector<phys_obstacle*> nearobss;
+    std::vector<phys_object*> nearobjs;
+    std::vector<uint32_t> nearsegs;
+    segment_batch walls;
+    for (size_t i = begin; i < end; ++i)
+    {
+      phys_object *obj = m_objects[i];
+      // not stepping in this substep
+      if (m_dt[i] == 0 or obj->is_gone())
         continue;
 
-      tot_force = tot_force + obs->act_on_object(map, obj);
+      collision_buffer &collisions = m_collisions[ichunk];
+      vec2d_d tot_force = {0, 0};
+      switch (m_broad_phase)
+      {
+        case broad_phase::brute_force:
+          tot_force = _sum_forces(map, obj, m_obstacles, m_objects, collisions);
+          break;
+
+        case broad_phase::vicinity_grid:
+          _collect_neighbours(map, _reach_of(obj), nearobss, nearobjs);
+          tot_force = _sum_forces(map, obj, nearobss, nearobjs, collisions);
+          break;
+      }
+
+      // static walls
+      if (not segtab.empty())
+      {
+        nearsegs.clear();
+        segtab.query(_reach_of(obj), nearsegs);
+        segtab.gather(nearsegs, walls);
+        const circle body {obj->get_position(), obj->get_radius()};
+        tot_force = tot_force + overlap_force(body, walls);
+      }
+
+      m_state.add_force(obj->get_phys_handle(), tot_force);
+    }
+  };
+
+  if (m_workers)
+  {
+    m_collisions.resize(m_workers->size() + 1);
+    m_workers->for_each_chunk(m_objects.size(), eval_chunk);
+  }
+  else
+  {
+    m_collisions.resize(2);
+    eval_chunk(0, 0, m_objects.size());
+  }
+}
+
+void
+mw::md_physics::_dispatch_collisions(area_map &map)
+{
+  for (collision_buffer &buf : m_collisions)
+  {
+    for (const auto &[obj, obs, force] : buf)
+    {
+      // same as if reported right away: gone objects don't collide anymore,
+      // nor act on other objects
+      if (not obj->is_gone())
+        obj->on_collision(map, obs);
+      else if (force.x != 0 or force.y != 0)
+      {
+        phys_object *subj = static_cast<phys_object*>(obs);
+        m_state.add_force(subj->get_phys_handle(), -force);
+      }
+    }
+    buf.clear();
+  }
+}
+
+void
+mw::md_physics::_advance_objects(area_map &map)
+{
+  // check whether objects are at rest
+  for (size_t i = 0; i < m_objects.size(); ++i)
+  {
+    if (m_dt[i] == 0 or m_restless[i])
+      continue;
+
+    const double a = mag(m_state.get_force(i))/m_objects[i]->get_mass();
+    const double v = mag(m_state.get_velocity(i));
+    if (v > m_sleep_velocity or a > m_sleep_acceleration)
+      m_restless[i] = true;
+  }
+
+  m_state.integrate(m_dt);
+  _sweep_fast_objects(map);
+
+  for (size_t i = 0; i < m_objects.size(); ++i)
+  {
+    if (m_dt[i] > 0 and not m_objects[i]->is_gone())
+      m_state.scatter(i);
+  }
+}
+
+void
+mw::md_physics::_sweep_fast_objects(area_map &map)
+{
+  collision_buffer_scope _ {m_collisions.back()};
+  const segment_table &segtab = map.get_static_segments();
+  std::vector<phys_obstacle*> nearobss;
+  std::vector<phys_object*> nearobjs;
+  std::vector<uint32_t> nearsegs;
+  collision_buffer ignored;
+
+  for (phys_object *obj : m_objects)
+  {
+    if (obj->is_gone())
+      continue;
+
+    const phys_handle h = obj->get_phys_handle();
+    const pt2d_d p0 = m_state.get_previous_position(h);
+    const vec2d_d dp = m_state.get_position(h) - p0;
+    const double r = obj->get_radius();
+    // objects moving less then their radius are handled by forces
+    if (mag2(dp) == 0 or mag2(dp) <= r*r)
+      continue;
+
+    const tunnel path {p0, dp, r};
+    const std::vector<phys_obstacle*> *obss = &m_obstacles;
+    const std::vector<phys_object*> *objs = &m_objects;
+    if (m_broad_phase == broad_phase::vicinity_grid)
+    {
+      const circle reach {p0 + dp/2, mag(dp)/2 + r};
+      _collect_neighbours(map, reach, nearobss, nearobjs);
+      obss = &nearobss;
+      objs = &nearobjs;
     }
 
-    // 2) vs other objects
-    for (phys_object *obj2 : m_objects)
+    // find the earliest impact
+    double tmin = DBL_MAX;
+    vec2d_d nmin;
+    phys_obstacle *hitobs = nullptr;
+    nearsegs.clear();
+    segtab.query({p0 + dp/2, mag(dp)/2 + r}, nearsegs);
+    for (const uint32_t k : nearsegs)
+    {
+      double t;
+      vec2d_d n;
+      if (sweep_tunnel_linesegm(path, segtab.get_segment(k), t, n) and t < tmin)
+      {
+        tmin = t;
+        nmin = n;
+        hitobs = segtab.get_owner(k);
+      }
+    }
+    for (phys_obstacle *obs : *obss)
+    {
+      double t;
+      vec2d_d n;
+      if (not obs->is_gone() and obs->sweep(path, t, n) and t < tmin)
+      {
+        tmin = t;
+        nmin = n;
+        hitobs = obs;
+      }
+    }
+    for (phys_object *obj2 : *objs)
     {
       if (obj2 == obj or obj2->is_gone())
         continue;
 
-      tot_force = tot_force + obj2->act_on_object(map, obj);
+      // other object may be moving too
+      pt2d_d q0 = obj2->get_position(), q1 = q0;
+      if (m_state.contains(obj2))
+      {
+        q0 = m_state.get_previous_position(obj2->get_phys_handle());
+        q1 = m_state.get_position(obj2->get_phys_handle());
+      }
+
+      // resting contacts are handled by forces, unless OBJ2 is asleep and
+      // its forces are not evaluated
+      const double R = r + obj2->get_radius();
+      if (mag2(p0 - q0) <= R*R)
+      {
+        if (obj2->is_sleeping() and 0 < tmin)
+        {
+          tmin = 0;
+          nmin = p0 - q0;
+          hitobs = obj2;
+        }
+        continue;
+      }
+
+      double t;
+      const tunnel path2 {q0, q1 - q0, obj2->get_radius()};
+      if (intersect_tunnel_tunnel(path, path2, t) > 0 and t < tmin)
+      {
+        tmin = t;
+        nmin = (p0 + dp*t) - (q0 + (q1 - q0)*t);
+        hitobs = obj2;
+      }
     }
 
-    dyn.emplace_back(obj, tot_force);
+    if (hitobs == nullptr)
+      continue;
+
+    // stop at the point of impact and drop the normal component of velocity
+    m_state.set_position(h, p0 + dp*tmin);
+    const vec2d_d v = m_state.get_velocity(h);
+    const double vn = dot(v, nmin);
+    if (vn < 0 and mag2(nmin) > 0)
+      m_state.set_velocity(h, v - nmin*(vn/mag2(nmin)));
+
+    phys_object *obj2 = dynamic_cast<phys_object*>(hitobs);
+    if (obj2)
+      _apply_impact(map, obj, obj2, tmin, ignored);
+
+    report_collision(map, obj, hitobs);
+    if (obj2)
+      report_collision(map, obj2, obj);
   }
 }
 
 void
-mw::md_physics::_advance_objects(area_map &map, double dt,
-                                 const std::vector<obj_dynamics> &dyn)
+mw::md_physics::_apply_impact(area_map &map, phys_object *obj,
+    phys_object *obj2, double t, collision_buffer &ignored)
 {
-  if (dt <= 0)
+  phys_obstacle *actor = dynamic_cast<phys_obstacle*>(obj);
+  if (actor == nullptr or not m_state.contains(obj2))
     return;
 
-  for (const auto &[obj, tot_force] : dyn)
+  // OBJ acts on OBJ2 from halfway to the deepest point of its path through
+  // OBJ2, for its whole step: this is what force evaluation would give if OBJ
+  // had landed inside OBJ2 at the end of the step
+  const phys_handle h = obj->get_phys_handle();
+  const phys_handle h2 = obj2->get_phys_handle();
+  const pt2d_d p0 = m_state.get_previous_position(h);
+  const vec2d_d dp = m_state.get_position(h) - p0;
+  const pt2d_d q0 = m_state.get_previous_position(h2);
+  const pt2d_d c = q0 + (m_state.get_position(h2) - q0)*t;
+  const pt2d_d phit = p0 + dp*t;
+  const double s = std::clamp(dot(c - phit, dp)/mag2(dp), 0., 1. - t);
+  const pt2d_d pmid = phit + dp*(s/2);
+
+  const pt2d_d oldpos = obj->get_position();
+  vec2d_d force;
+  set_position(obj, pmid);
   {
-    const pt2d_d p0 = obj->get_position();
-    const vec2d_d v0 = obj->get_velocity();
-    const vec2d_d a = tot_force/obj->get_mass();
+    // the impact is reported by the caller
+    collision_buffer_scope _ {ignored};
+    force = actor->act_on_object(map, obj2);
+  }
+  set_position(obj, oldpos);
+  ignored.clear();
+
+  // OBJ2 may be skipped by the rest of the tick, so its velocity is stored
+  // right away as well
+  const vec2d_d v2 =
+    m_state.get_velocity(h2) + force*(m_dt[h]/obj2->get_mass());
+  m_state.set_velocity(h2, v2);
+  set_velocity(obj2, v2);
+  obj2->wake_up();
+}
+
+// Objects closer then this are considered to be in contact.
+static constexpr double contact_margin = 1e-2;
+
+template <typename Yield> void
+mw::md_physics::_scan_contacts(const area_map &map, const phys_object *obj,
+    Yield&& yield)
+{
+  std::vector<phys_obstacle*> nearobss;
+  std::vector<phys_object*> nearobjs;
+  const std::vector<phys_object*> *objs = &m_objects;
+  if (m_broad_phase == broad_phase::vicinity_grid)
+  {
+    const circle reach {obj->get_position(), obj->get_radius() + contact_margin};
+    _collect_neighbours(map, reach, nearobss, nearobjs);
+    objs = &nearobjs;
+  }
+
+  for (phys_object *obj2 : *objs)
+  {
+    if (obj2 == obj or obj2->is_gone() or obj2->get_radius() <= 0 or
+        not m_state.contains(obj2))
+      continue;
+
+    const double R = obj->get_radius() + obj2->get_radius() + contact_margin;
+    if (mag2(obj->get_position() - obj2->get_position()) < R*R)
+      yield(obj2);
+  }
+}
+
+void
+mw::md_physics::_wake_touched(area_map &map)
+{
+  const auto is_sleeping = [] (const phys_object *obj) {
+    return obj->is_sleeping();
+  };
+  if (std::none_of(m_objects.begin(), m_objects.end(), is_sleeping))
+    return;
+
+  std::vector<phys_object*> stack;
+  for (size_t i = 0; i < m_objects.size(); ++i)
+  {
+    const phys_object *obj = m_objects[i];
+    if (m_dt[i] == 0 or obj->is_gone() or obj->get_radius() <= 0)
+      continue;
+
+    _scan_contacts(map, obj, [&] (phys_object *obj2) {
+      if (obj2->is_sleeping())
+        stack.push_back(obj2);
+    });
+  }
+
+  // wake whole islands
+  while (not stack.empty())
+  {
+    phys_object *obj = stack.back();
+    stack.pop_back();
+    if (not obj->is_sleeping())
+      continue;
+
+    obj->wake_up();
+    // join the finest rate class for the rest of the tick
+    m_rate_class[obj->get_phys_handle()] = 0;
+    _scan_contacts(map, obj, [&] (phys_object *obj2) {
+      if (obj2->is_sleeping())
+        stack.push_back(obj2);
+    });
+  }
+}
+
+void
+mw::md_physics::_update_sleep_states(area_map &map)
+{
+  const size_t n = m_objects.size();
+
+  // count idle ticks
+  for (size_t i = 0; i < n; ++i)
+  {
+    phys_object *obj = m_objects[i];
+    if (obj->is_gone() or obj->is_sleeping())
+      continue;
+
+    if (m_restless[i] or obj->get_radius() <= 0)
+      set_idle_ticks(obj, 0);
+    else
+      set_idle_ticks(obj, get_idle_ticks(obj) + 1);
+  }
+
+  // build contact islands
+  forest<size_t> islands;
+  islands.resize(n);
+  for (size_t i = 0; i < n; ++i)
+  {
+    const phys_object *obj = m_objects[i];
+    if (obj->is_gone() or obj->get_radius() <= 0)
+      continue;
+
+    _scan_contacts(map, obj, [&] (phys_object *obj2) {
+      islands.join(i, obj2->get_phys_handle());
+    });
+  }
+
+  // island sleeps only if all its objects are ready to
+  std::vector<bool> island_awake (n, false);
+  for (size_t i = 0; i < n; ++i)
+  {
+    const phys_object *obj = m_objects[i];
+    if (obj->is_gone())
+      continue;
+
+    const bool ready = obj->is_sleeping() or
+      (obj->get_radius() > 0 and get_idle_ticks(obj) >= m_sleep_ticks);
+    if (not ready)
+      island_awake[islands.find(i)] = true;
+  }
+  for (size_t i = 0; i < n; ++i)
+  {
+    phys_object *obj = m_objects[i];
+    if (obj->is_gone())
+      continue;
 
-    set_position(obj, p0 + v0*dt + a*dt*dt/2);
-    set_velocity(obj, v0 + a*dt);
+    const bool sleep = not island_awake[islands.find(i)];
+    if (sleep and not obj->is_sleeping())
+      put_to_sleep(obj);
+    else if (not sleep and obj->is_sleeping())
+      obj->wake_up();
   }
 }
@@ -19,7 +19,10 @@ mw::npc::~npc()
 
 void
 mw::npc::draw(const area_map &map) const
-{ map.get_canvas().draw_circle({get_position(), get_radius()}, m_color); }
+{
+  const pt2d_d pos = get_interpolated_position(map.get_interpolation());
+  map.get_canvas().draw_circle({pos, get_radius()}, m_color);
+}
 
 void
 mw::npc::update(area_map &map, int n_ticks_passed)
@@ -51,6 +54,13 @@ mw::npc::get_sights(vision_processor &visproc) const
     visproc.add_sight(s, 0);
 }
 
+bool
+mw::npc::obscures(const line_segment &ray) const
+{
+  double t;
+  return intersect(ray, circle {get_position(), get_radius()-0.01}, t) == 1;
+}
+
 void
 mw::npc::draw(const area_map &map, const sight &s) const
 {
@@ -58,7 +68,7 @@ mw::npc::draw(const area_map &map, const sight &s) const
   //aacircleRGBA(rend, pixpos.x, pixpos.y, visr, 0xFF, 0x00, 0x00, 0x55);
 
   map.get_canvas().draw_arc(
-      {get_position(), get_radius()},
+      {get_interpolated_position(map.get_interpolation()), get_radius()},
       s.sight_data.circle.cphi2,
       s.sight_data.circle.cphi1,
       m_color
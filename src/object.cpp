@@ -32,7 +32,7 @@ mw::phys_object::act_on_object(area_map &map, phys_object *subj)
   const double d =
     hypot(subj->get_position().x - m_position.x, subj->get_position().y - m_position.y);
   if (d < m_radius + subj->get_radius())
-    on_collision(map, subj);
+    report_collision(map, this, subj);
 
   const double overlap_area =
     _overlap_area({m_position, m_radius}, {subj->get_position(), subj->get_radius()});
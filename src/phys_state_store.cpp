@@ -0,0 +1,204 @@
+#include "phys_state_store.hpp"
+#include "object.hpp"
+
+#include <tuple>
+#include <algorithm>
+
+#if defined(__AVX__) || defined(__SSE2__)
+# include <immintrin.h>
+#endif
+
+
+void
+mw::phys_state_store::clear() noexcept
+{
+  // objects may be already deleted: don't touch them
+  m_objects.clear();
+  m_px.clear(); m_py.clear();
+  m_px0.clear(); m_py0.clear();
+  m_vx.clear(); m_vy.clear();
+  m_ax.clear(); m_ay.clear();
+  m_mass.clear();
+  m_friction.clear();
+  m_fx.clear(); m_fy.clear();
+}
+
+mw::phys_handle
+mw::phys_state_store::add(phys_object *obj)
+{
+  const phys_handle h = m_objects.size();
+  m_objects.push_back(obj);
+  m_px.push_back(0); m_py.push_back(0);
+  m_px0.push_back(0); m_py0.push_back(0);
+  m_vx.push_back(0); m_vy.push_back(0);
+  m_ax.push_back(0); m_ay.push_back(0);
+  m_mass.push_back(0);
+  m_friction.push_back(0);
+  m_fx.push_back(0); m_fy.push_back(0);
+  obj->m_phys_handle = h;
+  return h;
+}
+
+void
+mw::phys_state_store::remove(phys_handle h) noexcept
+{
+  const size_t last = m_objects.size() - 1;
+  for (std::vector<double> *field : {&m_px, &m_py, &m_px0, &m_py0, &m_vx,
+                                     &m_vy, &m_ax, &m_ay, &m_mass, &m_friction,
+                                     &m_fx, &m_fy})
+  {
+    (*field)[h] = (*field)[last];
+    field->pop_back();
+  }
+
+  m_objects[h]->m_phys_handle = no_phys_handle;
+  m_objects[h] = m_objects[last];
+  m_objects.pop_back();
+  if (h != last)
+    m_objects[h]->m_phys_handle = h;
+}
+
+bool
+mw::phys_state_store::contains(const phys_object *obj) const noexcept
+{
+  const phys_handle h = obj->get_phys_handle();
+  return h < m_objects.size() and m_objects[h] == obj;
+}
+
+void
+mw::phys_state_store::gather()
+{
+  for (size_t i = 0; i < m_objects.size(); ++i)
+  {
+    const phys_object *obj = m_objects[i];
+    m_px[i] = obj->m_position.x;
+    m_py[i] = obj->m_position.y;
+    m_vx[i] = obj->m_velocity.x;
+    m_vy[i] = obj->m_velocity.y;
+    m_ax[i] = obj->m_internal_acceleration.x;
+    m_ay[i] = obj->m_internal_acceleration.y;
+    m_mass[i] = obj->m_mass;
+    m_friction[i] = obj->m_friction_coeff;
+  }
+}
+
+void
+mw::phys_state_store::scatter(phys_handle h) const noexcept
+{
+  phys_object *obj = m_objects[h];
+  obj->m_position = {m_px[h], m_py[h]};
+  obj->m_velocity = {m_vx[h], m_vy[h]};
+}
+
+// Kernels below evaluate exactly the same operations (in the same order) as
+// the scalar tails, so results do not depend on the instruction set. This
+// relies on the file being compiled with -ffp-contract=off (see
+// CMakeLists.txt): otherwise scalar tails may be contracted into FMA while
+// intrinsics are not.
+
+void
+mw::phys_state_store::reset_forces() noexcept
+{
+  const size_t n = m_objects.size();
+  const double *m = m_mass.data(), *k = m_friction.data();
+  size_t i = 0;
+
+#if defined(__AVX__)
+  for (; i + 4 <= n; i += 4)
+  {
+    const __m256d mi = _mm256_loadu_pd(m + i);
+    const __m256d ki = _mm256_loadu_pd(k + i);
+    for (auto [a, v, f] : {std::tuple {m_ax.data(), m_vx.data(), m_fx.data()},
+                           std::tuple {m_ay.data(), m_vy.data(), m_fy.data()}})
+    {
+      const __m256d ma = _mm256_mul_pd(_mm256_loadu_pd(a + i), mi);
+      const __m256d kv = _mm256_mul_pd(ki, _mm256_loadu_pd(v + i));
+      _mm256_storeu_pd(f + i, _mm256_sub_pd(ma, kv));
+    }
+  }
+#elif defined(__SSE2__)
+  for (; i + 2 <= n; i += 2)
+  {
+    const __m128d mi = _mm_loadu_pd(m + i);
+    const __m128d ki = _mm_loadu_pd(k + i);
+    for (auto [a, v, f] : {std::tuple {m_ax.data(), m_vx.data(), m_fx.data()},
+                           std::tuple {m_ay.data(), m_vy.data(), m_fy.data()}})
+    {
+      const __m128d ma = _mm_mul_pd(_mm_loadu_pd(a + i), mi);
+      const __m128d kv = _mm_mul_pd(ki, _mm_loadu_pd(v + i));
+      _mm_storeu_pd(f + i, _mm_sub_pd(ma, kv));
+    }
+  }
+#endif
+
+  for (; i < n; ++i)
+  {
+    m_fx[i] = m_ax[i]*m[i] - k[i]*m_vx[i];
+    m_fy[i] = m_ay[i]*m[i] - k[i]*m_vy[i];
+  }
+}
+
+void
+mw::phys_state_store::integrate(const std::vector<double> &dt) noexcept
+{
+  const size_t n = m_objects.size();
+  const double *m = m_mass.data(), *h = dt.data();
+  size_t i = 0;
+
+  // remember where objects were
+  std::copy(m_px.begin(), m_px.end(), m_px0.begin());
+  std::copy(m_py.begin(), m_py.end(), m_py0.begin());
+
+  // p <- p + v*dt + a*dt*dt/2
+  // v <- v + a*dt
+  // where a = f/m
+#if defined(__AVX__)
+  const __m256d half4 = _mm256_set1_pd(0.5);
+  for (; i + 4 <= n; i += 4)
+  {
+    const __m256d mi = _mm256_loadu_pd(m + i);
+    const __m256d dt4 = _mm256_loadu_pd(h + i);
+    for (auto [p, v, f] : {std::tuple {m_px.data(), m_vx.data(), m_fx.data()},
+                           std::tuple {m_py.data(), m_vy.data(), m_fy.data()}})
+    {
+      const __m256d p0 = _mm256_loadu_pd(p + i);
+      const __m256d v0 = _mm256_loadu_pd(v + i);
+      const __m256d a = _mm256_div_pd(_mm256_loadu_pd(f + i), mi);
+      const __m256d adt = _mm256_mul_pd(a, dt4);
+      const __m256d dp = _mm256_add_pd(_mm256_mul_pd(v0, dt4),
+          _mm256_mul_pd(_mm256_mul_pd(adt, dt4), half4));
+      _mm256_storeu_pd(p + i, _mm256_add_pd(p0, dp));
+      _mm256_storeu_pd(v + i, _mm256_add_pd(v0, adt));
+    }
+  }
+#elif defined(__SSE2__)
+  const __m128d half2 = _mm_set1_pd(0.5);
+  for (; i + 2 <= n; i += 2)
+  {
+    const __m128d mi = _mm_loadu_pd(m + i);
+    const __m128d dt2 = _mm_loadu_pd(h + i);
+    for (auto [p, v, f] : {std::tuple {m_px.data(), m_vx.data(), m_fx.data()},
+                           std::tuple {m_py.data(), m_vy.data(), m_fy.data()}})
+    {
+      const __m128d p0 = _mm_loadu_pd(p + i);
+      const __m128d v0 = _mm_loadu_pd(v + i);
+      const __m128d a = _mm_div_pd(_mm_loadu_pd(f + i), mi);
+      const __m128d adt = _mm_mul_pd(a, dt2);
+      const __m128d dp = _mm_add_pd(_mm_mul_pd(v0, dt2),
+          _mm_mul_pd(_mm_mul_pd(adt, dt2), half2));
+      _mm_storeu_pd(p + i, _mm_add_pd(p0, dp));
+      _mm_storeu_pd(v + i, _mm_add_pd(v0, adt));
+    }
+  }
+#endif
+
+  for (; i < n; ++i)
+  {
+    const double ax = m_fx[i]/m[i];
+    const double ay = m_fy[i]/m[i];
+    m_px[i] = m_px[i] + (m_vx[i]*h[i] + ax*h[i]*h[i]*0.5);
+    m_py[i] = m_py[i] + (m_vy[i]*h[i] + ay*h[i]*h[i]*0.5);
+    m_vx[i] = m_vx[i] + ax*h[i];
+    m_vy[i] = m_vy[i] + ay*h[i];
+  }
+}
@@ -1,4 +1,28 @@
 #include "physics.hpp"
+#include "utl/simd.hpp"
+
+#include <cfloat>
+#include <assert.h>
+
+
+static thread_local mw::collision_buffer *g_collision_buffer = nullptr;
+
+void
+mw::report_collision(area_map &map, phys_object *obj, phys_obstacle *obs)
+{
+  if (g_collision_buffer)
+    g_collision_buffer->push_back({obj, obs});
+  else
+    obj->on_collision(map, obs);
+}
+
+mw::collision_buffer_scope::collision_buffer_scope(collision_buffer &buf)
+  noexcept
+: m_prev {g_collision_buffer}
+{ g_collision_buffer = &buf; }
+
+mw::collision_buffer_scope::~collision_buffer_scope()
+{ g_collision_buffer = m_prev; }
 
 
 void
@@ -47,3 +71,341 @@ mw::pushing(double m1, const pt2d_d &o1, vec2d_d &a1,
   a1 = a1 + da1;
   a2 = a2 + da2;
 }
+
+
+// Overlap force of a wall
+// -----------------------
+// A wall clipped to a circle of radius r is a chord with ends u and v
+// (relative to the center of the circle) subtending the angle alpha:
+//
+//   sin(alpha)   = |u x v| / (|u||v|)
+//   tan(alpha/2) = |u x v| / (|u||v| + u.v)
+//
+// Area of the overlap is approximated by r*r*(alpha - sin(alpha))/2 (i.e. by
+// the circular segment, also for walls ending inside the circle), and the
+// force is directed along the normal of the wall towards the center. Ends of
+// the wall lying inside the circle push it further, by (r - |e|)/2 along the
+// direction from the end e to the center.
+//
+// Angle alpha/2 is evaluated with the rational approximation of atan() from
+// Cephes, which is exact to a few ulps on [0, 1]; no other transcendental
+// functions are involved. Compared to the former evaluation of the angles with
+// atan2() (see _reference_overlap_force()), forces agree within
+// overlap_force_tolerance*r*r per wall. Walls passing exactly through the
+// center of the circle may get the opposite direction of the force (either one
+// is valid). Builds configured with CHECK_OVERLAP_FORCE check every wall
+// against the reference.
+//
+// Vectorized kernels evaluate exactly the same operations (in the same order)
+// as the scalar one; forces of individual walls are summed up sequentially, so
+// results do not depend on the instruction set. This relies on the file being
+// compiled with -ffp-contract=off (see CMakeLists.txt).
+
+static constexpr double overlap_force_tolerance = 1e-11;
+
+#ifdef MW_CHECK_OVERLAP_FORCE
+// Former implementation of overlap_force(), based on cast_sight(). The chord
+// angle is measured with atan2() rather than taken from the sight, whose angles
+// are not radians with MW_VISION_PSEUDO_ANGLES.
+static mw::vec2d_d
+_reference_overlap_force(const mw::circle &c, const mw::line_segment &wall)
+{
+  mw::vec2d_d force = {0, 0};
+
+  mw::sight s;
+  const double r = c.radius;
+  if (cast_sight(c, wall, s))
+  {
+    const mw::vec2d_d a = wall(s.sight_data.line.t1) - c.center;
+    const mw::vec2d_d b = wall(s.sight_data.line.t2) - c.center;
+    const double dphi = fabs(atan2(a.x*b.y - a.y*b.x, dot(a, b)));
+    const double sector_area = r*r*dphi/2;
+    const double triang_area = r*r*sin(dphi/2)*cos(dphi/2);
+    const double overlap_area = sector_area - triang_area;
+    mw::vec2d_d n = normalized(mw::vec2d_d(-wall.direction.y, wall.direction.x));
+    n = n * copysign(1., dot(n, c.center - wall(s.sight_data.line.t1)));
+    force = force + overlap_area * n;
+
+    // special treatment for corners
+    double t1 = s.sight_data.line.t1;
+    double t2 = s.sight_data.line.t2;
+    if (t1 > t2)
+      std::swap(t1, t2);
+    if (t1 == 0)
+    {
+      const mw::vec2d_d r = c.center - wall(t1);
+      force = force + normalized(r)*(c.radius - mag(r))/2;
+    }
+    if (t2 == 1)
+    {
+      const mw::vec2d_d r = c.center - wall(t2);
+      force = force + normalized(r)*(c.radius - mag(r))/2;
+    }
+  }
+  return force;
+}
+
+static bool
+_agrees_with_reference(const mw::circle &c, const mw::line_segment &wall,
+    const mw::vec2d_d &force)
+{
+  const mw::vec2d_d ref = _reference_overlap_force(c, wall);
+  const double tol = overlap_force_tolerance*c.radius*c.radius;
+  // either direction is valid for walls through the center
+  return mag(force - ref) <= tol or mag(force + ref) <= tol;
+}
+
+#define CHECK_OVERLAP_FORCE(c, wall, force) \
+  assert(_agrees_with_reference(c, wall, force))
+#else
+#define CHECK_OVERLAP_FORCE(c, wall, force)
+#endif
+
+static constexpr double atan_p[] = {
+  -8.750608600031904122785e-1,
+  -1.615753718733365076637e1,
+  -7.500855792314704667340e1,
+  -1.228866684490136173410e2,
+  -6.485021904942025371773e1,
+};
+static constexpr double atan_q[] = {
+  /* 1, */
+  2.485846490142306297962e1,
+  1.650270098316988542046e2,
+  4.328810604912902668951e2,
+  4.853903996359136964868e2,
+  1.945506571482613964425e2,
+};
+
+// Same as MAXPD/MINPD (unlike std::max/min, the second operand is returned
+// if the operands are equal).
+static inline double
+_max(double a, double b) noexcept
+{ return a > b ? a : b; }
+
+static inline double
+_min(double a, double b) noexcept
+{ return a < b ? a : b; }
+
+// atan(x) for x in [0, 1]
+static inline double
+_atan01(double x) noexcept
+{
+  const bool big = x > 0.66;
+  const double y0 = big ? M_PI_4 : 0.;
+  const double xr = big ? (x - 1.)/(x + 1.) : x;
+  const double z = xr*xr;
+  double p = atan_p[0], q = z + atan_q[0];
+  for (int k = 1; k < 5; ++k)
+  {
+    p = p*z + atan_p[k];
+    q = q*z + atan_q[k];
+  }
+  return y0 + (xr + xr*(z*p/q));
+}
+
+static inline mw::vec2d_d
+_overlap_force(double cx, double cy, double r, double ox, double oy,
+    double dx, double dy) noexcept
+{
+  // intersections of the wall line with the circle: O + t*d
+  const double Ox = ox - cx, Oy = oy - cy;
+  const double dOd = Ox*dx + Oy*dy;
+  const double d2 = dx*dx + dy*dy;
+  const double dO2 = Ox*Ox + Oy*Oy;
+  const double D = dOd*dOd - d2*(dO2 - r*r);
+  const double root = sqrt(_max(D, 0.));
+  const double t1 = ((0. - dOd) - root)/d2;
+  const double t2 = ((0. - dOd) + root)/d2;
+  if (not (D >= 0 and t2 >= 0 and t1 < 1))
+    return {0, 0};
+
+  // chord
+  const double s1 = _max(t1, 0.), s2 = _min(t2, 1.);
+  const double ux = Ox + s1*dx, uy = Oy + s1*dy;
+  const double vx = Ox + s2*dx, vy = Oy + s2*dy;
+  const double cross = fabs(ux*vy - uy*vx);
+  const double uv = sqrt((ux*ux + uy*uy)*(vx*vx + vy*vy));
+  const double uxv = ux*vx + uy*vy;
+  const double at = _atan01(cross/_max(uv + fabs(uxv), DBL_MIN));
+  const double half = uxv >= 0 ? at : M_PI_2 - at;
+  const double sina = cross/_max(uv, DBL_MIN);
+  const double area = r*r*(2.*half - sina)*0.5;
+
+  // normal towards the center
+  const double len = sqrt(d2);
+  const double nx = (0. - dy)/len, ny = dx/len;
+  const double side = copysign(1., nx*(0. - Ox) + ny*(0. - Oy));
+  double fx = area*side*nx, fy = area*side*ny;
+
+  // wall ends
+  if (t1 <= 0)
+  {
+    const double ex = 0. - Ox, ey = 0. - Oy;
+    const double le = sqrt(ex*ex + ey*ey);
+    if (le > 0)
+    {
+      fx = fx + ex/le*(r - le)*0.5;
+      fy = fy + ey/le*(r - le)*0.5;
+    }
+  }
+  if (t2 >= 1)
+  {
+    const double ex = 0. - (Ox + dx), ey = 0. - (Oy + dy);
+    const double le = sqrt(ex*ex + ey*ey);
+    if (le > 0)
+    {
+      fx = fx + ex/le*(r - le)*0.5;
+      fy = fy + ey/le*(r - le)*0.5;
+    }
+  }
+
+  return {fx, fy};
+}
+
+#if defined(__AVX__) || defined(__SSE2__)
+namespace {
+
+using V = mw::simd_ops;
+using vtype = V::type;
+
+// m ? b : a
+inline vtype
+_select(vtype m, vtype a, vtype b)
+{ return V::bit_or(V::bit_and(m, b), V::bit_andnot(m, a)); }
+
+inline vtype
+_atan01(vtype x)
+{
+  const vtype big = V::gt(x, V::set1(0.66));
+  const vtype y0 = V::bit_and(big, V::set1(M_PI_4));
+  const vtype one = V::set1(1.);
+  const vtype xr = _select(big, x, V::div(V::sub(x, one), V::add(x, one)));
+  const vtype z = V::mul(xr, xr);
+  vtype p = V::set1(atan_p[0]), q = V::add(z, V::set1(atan_q[0]));
+  for (int k = 1; k < 5; ++k)
+  {
+    p = V::add(V::mul(p, z), V::set1(atan_p[k]));
+    q = V::add(V::mul(q, z), V::set1(atan_q[k]));
+  }
+  return V::add(y0, V::add(xr, V::mul(xr, V::div(V::mul(z, p), q))));
+}
+
+inline vtype
+_abs(vtype x)
+{ return V::bit_andnot(V::set1(-0.), x); }
+
+// push-out by a wall end E (relative to the center), masked by M
+inline void
+_add_end_force(vtype m, vtype r, vtype ex, vtype ey, vtype &fx, vtype &fy)
+{
+  const vtype half = V::set1(0.5);
+  const vtype le = V::sqrt(V::add(V::mul(ex, ex), V::mul(ey, ey)));
+  const vtype ok = V::bit_and(m, V::gt(le, V::set1(0.)));
+  const vtype k = V::sub(r, le);
+  const vtype cx = V::mul(V::mul(V::div(ex, le), k), half);
+  const vtype cy = V::mul(V::mul(V::div(ey, le), k), half);
+  fx = V::add(fx, V::bit_and(ok, cx));
+  fy = V::add(fy, V::bit_and(ok, cy));
+}
+
+// Forces of walls [i, i + width) of the batch
+inline void
+_overlap_force(double cx_, double cy_, double r_, const mw::segment_batch &w,
+    size_t i, double *fxout, double *fyout)
+{
+  const vtype zero = V::set1(0.), one = V::set1(1.), half = V::set1(0.5);
+  const vtype cx = V::set1(cx_), cy = V::set1(cy_), r = V::set1(r_);
+  const vtype dx = V::load(w.dx.data() + i), dy = V::load(w.dy.data() + i);
+
+  // intersections of the wall line with the circle: O + t*d
+  const vtype Ox = V::sub(V::load(w.ox.data() + i), cx);
+  const vtype Oy = V::sub(V::load(w.oy.data() + i), cy);
+  const vtype dOd = V::add(V::mul(Ox, dx), V::mul(Oy, dy));
+  const vtype d2 = V::add(V::mul(dx, dx), V::mul(dy, dy));
+  const vtype dO2 = V::add(V::mul(Ox, Ox), V::mul(Oy, Oy));
+  const vtype D =
+    V::sub(V::mul(dOd, dOd), V::mul(d2, V::sub(dO2, V::mul(r, r))));
+  const vtype root = V::sqrt(V::max(D, zero));
+  const vtype t1 = V::div(V::sub(V::sub(zero, dOd), root), d2);
+  const vtype t2 = V::div(V::add(V::sub(zero, dOd), root), d2);
+  const vtype hit = V::bit_and(V::ge(D, zero),
+      V::bit_and(V::ge(t2, zero), V::lt(t1, one)));
+
+  // chord
+  const vtype s1 = V::max(t1, zero), s2 = V::min(t2, one);
+  const vtype ux = V::add(Ox, V::mul(s1, dx)), uy = V::add(Oy, V::mul(s1, dy));
+  const vtype vx = V::add(Ox, V::mul(s2, dx)), vy = V::add(Oy, V::mul(s2, dy));
+  const vtype cross = _abs(V::sub(V::mul(ux, vy), V::mul(uy, vx)));
+  const vtype uv = V::sqrt(V::mul(V::add(V::mul(ux, ux), V::mul(uy, uy)),
+                                  V::add(V::mul(vx, vx), V::mul(vy, vy))));
+  const vtype uxv = V::add(V::mul(ux, vx), V::mul(uy, vy));
+  const vtype tiny = V::set1(DBL_MIN);
+  const vtype at = _atan01(V::div(cross, V::max(V::add(uv, _abs(uxv)), tiny)));
+  const vtype halfa =
+    _select(V::ge(uxv, zero), V::sub(V::set1(M_PI_2), at), at);
+  const vtype sina = V::div(cross, V::max(uv, tiny));
+  const vtype area = V::mul(V::mul(V::mul(r, r),
+        V::sub(V::mul(V::set1(2.), halfa), sina)), half);
+
+  // normal towards the center
+  const vtype len = V::sqrt(d2);
+  const vtype nx = V::div(V::sub(zero, dy), len), ny = V::div(dx, len);
+  const vtype side0 = V::add(V::mul(nx, V::sub(zero, Ox)),
+                             V::mul(ny, V::sub(zero, Oy)));
+  const vtype sign = V::bit_and(side0, V::set1(-0.));
+  const vtype side = V::bit_or(one, sign);
+  vtype fx = V::mul(V::mul(area, side), nx);
+  vtype fy = V::mul(V::mul(area, side), ny);
+
+  // wall ends
+  _add_end_force(V::le(t1, zero), r, V::sub(zero, Ox), V::sub(zero, Oy),
+      fx, fy);
+  _add_end_force(V::ge(t2, one), r, V::sub(zero, V::add(Ox, dx)),
+      V::sub(zero, V::add(Oy, dy)), fx, fy);
+
+  V::store(fxout, V::bit_and(hit, fx));
+  V::store(fyout, V::bit_and(hit, fy));
+}
+
+} // anonymous namespace
+#endif
+
+mw::vec2d_d
+mw::overlap_force(const circle &c, const line_segment &wall)
+{
+  const vec2d_d force = _overlap_force(c.center.x, c.center.y, c.radius,
+      wall.origin.x, wall.origin.y, wall.direction.x, wall.direction.y);
+  CHECK_OVERLAP_FORCE(c, wall, force);
+  return force;
+}
+
+mw::vec2d_d
+mw::overlap_force(const circle &c, const segment_batch &walls)
+{
+  const size_t n = walls.size();
+  vec2d_d force = {0, 0};
+  size_t i = 0;
+
+#if defined(__AVX__) || defined(__SSE2__)
+  double fx[V::width], fy[V::width];
+  for (; i + V::width <= n; i += V::width)
+  {
+    _overlap_force(c.center.x, c.center.y, c.radius, walls, i, fx, fy);
+    for (size_t k = 0; k < V::width; ++k)
+    {
+      CHECK_OVERLAP_FORCE(c, walls[i + k], vec2d_d(fx[k], fy[k]));
+      force = force + vec2d_d {fx[k], fy[k]};
+    }
+  }
+#endif
+
+  for (; i < n; ++i)
+  {
+    const vec2d_d f = _overlap_force(c.center.x, c.center.y, c.radius,
+        walls.ox[i], walls.oy[i], walls.dx[i], walls.dy[i]);
+    CHECK_OVERLAP_FORCE(c, walls[i], f);
+    force = force + f;
+  }
+  return force;
+}
@@ -8,7 +8,10 @@ mw::player::player(const pt2d_d &pos, double movespeed)
   m_move_dir {0, 0},
   m_speed {movespeed},
   m_glowtex {nullptr}
-{ }
+{
+  m_glow_vision.set_engine(vision_engine::angular_sweep);
+  m_glow_vision.set_incremental(true);
+}
 
 mw::player::~player()
 {
@@ -20,18 +23,19 @@ void
 mw::player::draw(const area_map &map) const
 {
   SDL_Renderer *rend = map.get_sdl().get_renderer();
-  const pt2d_i pixpos = map.point_to_pixels(get_position());
+  const pt2d_d pos = get_interpolated_position(map.get_interpolation());
+  const pt2d_i pixpos = map.point_to_pixels(pos);
 
   if (m_glowtex)
   {
     const rectangle dstbox = {
-      get_position() - vec2d_d(m_glowradius, m_glowradius),
+      pos - vec2d_d(m_glowradius, m_glowradius),
       m_glowradius*2, m_glowradius*2
     };
-    vision_processor localvision;
-    localvision.set_ignore(this);
+    m_glow_vision.reset();
+    m_glow_vision.set_ignore(this);
     map.blit_glow_with_shadowcast(m_glowtex, dstbox, 0x77,
-        blit_flags::draw_sights, localvision);
+        blit_flags::draw_sights, m_glow_vision);
   }
 
   const double r = 0.5 * map.get_scale();
@@ -50,11 +54,19 @@ mw::player::get_sights(vision_processor &visproc) const
     visproc.add_sight(s, 0);
 }
 
+bool
+mw::player::obscures(const line_segment &ray) const
+{
+  double t;
+  return intersect(ray, circle {get_position(), 0.5}, t) == 1;
+}
+
 void
 mw::player::draw(const area_map &map, const sight &s) const
 {
   SDL_Renderer *rend = map.get_sdl().get_renderer();
-  const pt2d_i pixpos = map.point_to_pixels(get_position());
+  const pt2d_i pixpos =
+    map.point_to_pixels(get_interpolated_position(map.get_interpolation()));
   const double r = 0.5 * map.get_scale();
   double cphi1 = s.sight_data.circle.cphi1;
   double cphi2 = s.sight_data.circle.cphi2;
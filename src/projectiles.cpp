@@ -1,5 +1,6 @@
 #include "projectiles.hpp"
 #include "effects.hpp"
+#include "physics.hpp"
 
 
 mw::simple_projectile::simple_projectile(const pt2d_d &origin, const vec2d_d &dir,
@@ -32,13 +33,14 @@ mw::simple_projectile::draw(const area_map &map) const
     return;
 
   SDL_Renderer *rend = map.get_sdl().get_renderer();
-  const double curpathlen = mag(get_position() - m_origin);
+  const pt2d_d pos = get_interpolated_position(map.get_interpolation());
+  const double curpathlen = mag(pos - m_origin);
   const double linelen = sqrt(fabs(m_maxdist - curpathlen))*m_lencoef;
 
   if (m_glowtex)
   {
     const rectangle dstbox = {
-      get_position() - vec2d_d(m_glowradius, m_glowradius),
+      pos - vec2d_d(m_glowradius, m_glowradius),
       m_glowradius*2, m_glowradius*2
     };
     map.blit_glow_with_shadowcast(m_glowtex, dstbox, m_glowalpha,
@@ -49,10 +51,10 @@ mw::simple_projectile::draw(const area_map &map) const
   if (curpathlen < linelen)
     start = m_origin;
   else
-    start = get_position() - linelen*m_dir;
+    start = pos - linelen*m_dir;
 
   const auto [xstart, ystart] = map.point_to_pixels(start);
-  const auto [xend, yend] = map.point_to_pixels(get_position());
+  const auto [xend, yend] = map.point_to_pixels(pos);
 
   const color_rgba rgba {m_line_color};
   SDL_SetRenderDrawColor(rend, rgba.r, rgba.g, rgba.b, rgba.a);
@@ -78,7 +80,7 @@ mw::simple_projectile::act_on_object(area_map &map, phys_object *subj)
   const double d = mag(subjpos - mypos);
   if (d < subj->get_radius())
   {
-    on_collision(map, subj);
+    report_collision(map, this, subj);
     return normalized(subjpos - mypos)*get_mass()*mag(get_velocity())*50;
   }
   else
@@ -90,6 +92,8 @@ mw::simple_bullet::on_collision(area_map &map, phys_obstacle *obs)
   if (phys_object *obj = dynamic_cast<phys_object*>(obs))
   {
     const vec2d_d n = get_position() - obj->get_position();
+    // hits wake any phys-object, whatever it does with the hit
+    obj->wake_up();
     obj->receive_hit(map,
         make_pointwise_hit(m_hit_strength).with_surface_normal(n));
   }
@@ -0,0 +1,59 @@
+#include "segment_table.hpp"
+
+#include <algorithm>
+
+
+void
+mw::segment_table::clear()
+{
+  m_segments.clear();
+  m_owners.clear();
+  m_tree.clear();
+}
+
+void
+mw::segment_table::add(const line_segment &seg, phys_obstacle *owner)
+{
+  m_segments.push_back(seg);
+  m_owners.push_back(owner);
+}
+
+void
+mw::segment_table::build()
+{
+  std::vector<aabb> boxes;
+  boxes.reserve(m_segments.size());
+  for (size_t i = 0; i < m_segments.size(); ++i)
+  {
+    const line_segment seg = m_segments[i];
+    const pt2d_d a = seg.origin, b = seg(1);
+    boxes.push_back({
+      std::min(a.x, b.x), std::min(a.y, b.y),
+      std::max(a.x, b.x), std::max(a.y, b.y),
+    });
+  }
+  m_tree.build(boxes);
+}
+
+void
+mw::segment_table::query(const circle &c, std::vector<uint32_t> &result)
+  const
+{
+  const size_t first = result.size();
+  const aabb box {
+    c.center.x - c.radius, c.center.y - c.radius,
+    c.center.x + c.radius, c.center.y + c.radius,
+  };
+  m_tree.query(box, [&] (uint32_t i) { result.push_back(i); });
+  // keep the order of summation independent of the shape of the tree
+  std::sort(result.begin() + first, result.end());
+}
+
+void
+mw::segment_table::gather(const std::vector<uint32_t> &idxs,
+    segment_batch &batch) const
+{
+  batch.clear();
+  for (const uint32_t i : idxs)
+    batch.push_back(m_segments[i]);
+}
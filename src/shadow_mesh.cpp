@@ -0,0 +1,78 @@
+#include "shadow_mesh.hpp"
+#include "logging.h"
+
+#include <SDL2/SDL2_gfxPrimitives.h>
+
+
+bool mw::shadow_mesh::gm_use_geometry = true;
+
+void
+mw::shadow_mesh::add_polygon(const vision_vector<pt2d_d> &points,
+    const mapping &world_to_target, color_t color)
+{
+  if (points.size() < 3)
+    return;
+
+  SDL_Vertex vert;
+  vert.color.r = (color >>  0) & 0xFF;
+  vert.color.g = (color >>  8) & 0xFF;
+  vert.color.b = (color >> 16) & 0xFF;
+  vert.color.a = (color >> 24) & 0xFF;
+  vert.tex_coord = {0, 0};
+
+  // fan of triangles around the first vertex
+  const int first = m_vertices.size();
+  m_polygons.push_back(first);
+  for (const pt2d_d &p : points)
+  {
+    const pt2d_d q = world_to_target(p);
+    vert.position = {float(q.x), float(q.y)};
+    m_vertices.push_back(vert);
+  }
+  for (size_t i = 2; i < points.size(); ++i)
+  {
+    m_indices.push_back(first);
+    m_indices.push_back(first + i - 1);
+    m_indices.push_back(first + i);
+  }
+}
+
+void
+mw::shadow_mesh::render(SDL_Renderer *rend) const
+{
+  if (m_polygons.empty())
+    return;
+
+  if (gm_use_geometry)
+  {
+    if (SDL_RenderGeometry(rend, nullptr, m_vertices.data(), m_vertices.size(),
+          m_indices.data(), m_indices.size()) == 0)
+      return;
+    warning("failed to render shadow geometry (%s), falling back to polygons",
+        SDL_GetError());
+    gm_use_geometry = false;
+  }
+  _render_polygons(rend);
+}
+
+void
+mw::shadow_mesh::_render_polygons(SDL_Renderer *rend) const
+{
+  std::vector<int16_t> xs, ys;
+  for (size_t ipoly = 0; ipoly < m_polygons.size(); ++ipoly)
+  {
+    const size_t begin = m_polygons[ipoly];
+    const size_t end = ipoly + 1 < m_polygons.size() ? m_polygons[ipoly + 1]
+                                                     : m_vertices.size();
+    xs.clear();
+    ys.clear();
+    for (size_t i = begin; i < end; ++i)
+    {
+      xs.push_back(m_vertices[i].position.x);
+      ys.push_back(m_vertices[i].position.y);
+    }
+    const SDL_Color &c = m_vertices[begin].color;
+    filledPolygonRGBA(rend, xs.data(), ys.data(), xs.size(), c.r, c.g, c.b,
+        c.a);
+  }
+}
@@ -21,40 +21,67 @@ mw::simple_ai::update(const area_map &map, int n_ticks_passed)
   sync_path(map);
 
   // TODO: calculate once but make a propper decay according to n_ticks_passed
-  if (m_current_time - m_exploration.timestamp > 10)
+  if (is_exploration_due(m_current_time))
   {
+    // full vision is only needed to explore
+    if (not m_vision.is_requested)
+      process_vision(map);
     // TODO: sync vision/mark raduis with NPC's vision radius
     m_exploration.destination = m_exploration.explr(m_vision.visproc);
     m_exploration.timestamp = m_current_time;
   }
+  m_vision.is_requested = false;
 }
 
 void
-mw::simple_ai::sync_vision(const area_map &map)
+mw::simple_ai::request_vision(const area_map &map, vision_service &service,
+    int n_ticks_passed)
 {
-  if (m_vision.timestamp == m_current_time)
+  // the same check as the next update() will do
+  if (not is_exploration_due(m_current_time + n_ticks_passed))
     return;
-  // update timestamp (whatever will be done below is the final state for this
-  // timepoint)
-  m_vision.timestamp = m_current_time;
+  service.request({m_slave.get_position(), m_slave.get_vision_radius()},
+      &m_slave, m_vision.visproc);
+  m_vision.is_requested = true;
+}
 
-  // re-process sights
+void
+mw::simple_ai::process_vision(const area_map &map)
+{
   m_vision.visproc.reset();
   m_vision.visproc.set_source(
       {m_slave.get_position(), m_slave.get_vision_radius()});
   m_vision.visproc.set_ignore(&m_slave);
-  m_vision.visproc.load_obstacles(map.get_vis_obstacles());
+  m_vision.visproc.load_obstacles(map);
   m_vision.visproc.process();
+}
+
+void
+mw::simple_ai::sync_vision(const area_map &map)
+{
+  if (m_vision.timestamp == m_current_time)
+    return;
+  // update timestamp (whatever will be done below is the final state for this
+  // timepoint)
+  m_vision.timestamp = m_current_time;
 
   // update vision on player
   m_vision.visible_player = std::nullopt;
-  for (const sight &s : m_vision.visproc.get_sights())
+  const pt2d_d pos = m_slave.get_position();
+  const double r = m_slave.get_vision_radius();
+  vis_obstacle_list &obstacles = m_vision.obstacles;
+  map.collect_vis_obstacles({pos, r}, obstacles);
+  for (const vis_obstacle *obs : obstacles)
   {
-    //info("see %p", s.static_data->obs);
-    const player *plyr = dynamic_cast<const player*>(s.static_data.obs);
-    if (plyr)
+    const player *plyr = dynamic_cast<const player*>(obs);
+    if (plyr == nullptr)
+      continue;
+
+    // any visible part of the player's body will do
+    const circle body {plyr->get_position(), plyr->get_radius()};
+    if (mag(body.center - pos) - body.radius <= r and
+        map.has_line_of_sight(pos, body, {&m_slave, plyr}))
     {
-      //info("see player");
       m_vision.visible_player = plyr;
       break;
     }
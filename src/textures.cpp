@@ -3,6 +3,8 @@
 
 #include <SDL2/SDL_image.h>
 
+#include <algorithm>
+
 #include <boost/format.hpp>
 
 
@@ -65,10 +67,138 @@ mw::create_texture(SDL_Renderer *rend, int access, int w, int h)
   return tex;
 }
 
+static int
+_bucket_size(int n)
+{
+  const int g = mw::render_target_pool::granularity;
+  return (std::max(n, 1) + g - 1)/g*g;
+}
+
+mw::render_target_pool::~render_target_pool()
+{
+  for (const auto &ent : m_released)
+    SDL_DestroyTexture(ent.second.tex);
+}
+
+SDL_Texture*
+mw::render_target_pool::acquire(int w, int h)
+{
+  const std::pair<int, int> size {_bucket_size(w), _bucket_size(h)};
+  const auto it = m_free.find(size);
+  if (it != m_free.end())
+  {
+    // take the most recently released one
+    std::deque<size_t> &bucket = it->second;
+    const auto relit = m_released.find(bucket.back());
+    SDL_Texture *tex = relit->second.tex;
+    m_released.erase(relit);
+    bucket.pop_back();
+    if (bucket.empty())
+      m_free.erase(it);
+    m_free_pixels -= size_t(size.first)*size.second;
+    return tex;
+  }
+
+  m_ncreated += 1;
+  return create_texture(m_rend, SDL_TEXTUREACCESS_TARGET, size.first,
+      size.second);
+}
+
+void
+mw::render_target_pool::release(SDL_Texture *tex)
+{
+  uint32_t format;
+  int access, w, h;
+  SDL_QueryTexture(tex, &format, &access, &w, &h);
+  const size_t stamp = m_stamp++;
+  m_released.emplace(stamp, free_texture {tex, {w, h}});
+  m_free[{w, h}].push_back(stamp);
+  m_free_pixels += size_t(w)*h;
+  _trim();
+}
+
+void
+mw::render_target_pool::set_max_free_pixels(size_t n)
+{
+  m_max_free_pixels = n;
+  _trim();
+}
+
+void
+mw::render_target_pool::_trim()
+{
+  while (m_free_pixels > m_max_free_pixels)
+  {
+    // the earliest released texture is the first one of its bucket as well
+    const auto oldest = m_released.begin();
+    const std::pair<int, int> size = oldest->second.size;
+    const auto it = m_free.find(size);
+    it->second.pop_front();
+    if (it->second.empty())
+      m_free.erase(it);
+
+    SDL_DestroyTexture(oldest->second.tex);
+    m_released.erase(oldest);
+    m_free_pixels -= size_t(size.first)*size.second;
+  }
+}
+
 SDL_Texture*
 mw::get_render_target(SDL_Renderer *rend) noexcept
 { return SDL_GetRenderTarget(rend); }
 
+SDL_BlendMode
+mw::premultiplied_blend_mode()
+{
+  static const SDL_BlendMode mode = SDL_ComposeCustomBlendMode(
+      SDL_BLENDFACTOR_ONE,
+      SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA,
+      SDL_BLENDOPERATION_ADD,
+      SDL_BLENDFACTOR_ONE,
+      SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA,
+      SDL_BLENDOPERATION_ADD);
+  return mode;
+}
+
+SDL_BlendMode
+mw::premultiplied_color_blend_mode()
+{
+  static const SDL_BlendMode mode = SDL_ComposeCustomBlendMode(
+      SDL_BLENDFACTOR_ONE,
+      SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA,
+      SDL_BLENDOPERATION_ADD,
+      SDL_BLENDFACTOR_ZERO,
+      SDL_BLENDFACTOR_ONE,
+      SDL_BLENDOPERATION_ADD);
+  return mode;
+}
+
+SDL_BlendMode
+mw::light_blend_mode()
+{
+  static const SDL_BlendMode mode = SDL_ComposeCustomBlendMode(
+      SDL_BLENDFACTOR_SRC_ALPHA,
+      SDL_BLENDFACTOR_ONE,
+      SDL_BLENDOPERATION_ADD,
+      SDL_BLENDFACTOR_ONE,
+      SDL_BLENDFACTOR_ONE,
+      SDL_BLENDOPERATION_ADD);
+  return mode;
+}
+
+SDL_BlendMode
+mw::lit_blend_mode()
+{
+  static const SDL_BlendMode mode = SDL_ComposeCustomBlendMode(
+      SDL_BLENDFACTOR_DST_ALPHA,
+      SDL_BLENDFACTOR_ONE,
+      SDL_BLENDOPERATION_ADD,
+      SDL_BLENDFACTOR_ZERO,
+      SDL_BLENDFACTOR_ONE,
+      SDL_BLENDOPERATION_ADD);
+  return mode;
+}
+
 void
 mw::set_render_target(SDL_Renderer *rend, SDL_Texture *target)
 {
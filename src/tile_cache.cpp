@@ -0,0 +1,61 @@
+#include "tile_cache.hpp"
+
+#include <cmath>
+
+
+static uint64_t
+_tile_key(int level, int ix, int iy)
+{
+  return uint64_t(uint16_t(level)) << 48
+       | uint64_t(uint32_t(ix) & 0xFFFFFF) << 24
+       | uint64_t(uint32_t(iy) & 0xFFFFFF);
+}
+
+int
+mw::tile_cache::get_level(double scale) noexcept
+{ return std::lround(std::log2(scale)*4); }
+
+double
+mw::tile_cache::get_level_scale(int level) noexcept
+{ return std::exp2(level/4.); }
+
+SDL_Texture*
+mw::tile_cache::get(int level, int ix, int iy, bool &is_new)
+{
+  const uint64_t key = _tile_key(level, ix, iy);
+  const auto it = m_tiles.find(key);
+  is_new = it == m_tiles.end();
+  if (not is_new)
+  {
+    it->second.frame = m_frame;
+    return it->second.tex;
+  }
+
+  SDL_Texture *tex = m_pool.acquire(tile_size, tile_size);
+  m_tiles.emplace(key, entry {tex, m_frame});
+  return tex;
+}
+
+void
+mw::tile_cache::next_frame()
+{
+  for (auto it = m_tiles.begin(); it != m_tiles.end();)
+  {
+    if (it->second.frame < m_frame)
+    {
+      m_pool.release(it->second.tex);
+      it = m_tiles.erase(it);
+    }
+    else
+      ++it;
+  }
+  m_frame += 1;
+}
+
+void
+mw::tile_cache::clear()
+{
+  for (const auto &ent : m_tiles)
+    m_pool.release(ent.second.tex);
+  m_tiles.clear();
+}
@@ -1,11 +1,15 @@
 #include "vision.hpp"
 #include "object.hpp"
+#include "area_map.hpp"
 #include "exceptions.hpp"
-
-#include <SDL2/SDL2_gfxPrimitives.h>
+#include "shadow_mesh.hpp"
+#include "utl/simd.hpp"
 
 #include <boost/format.hpp>
 
+#include <algorithm>
+#include <cmath>
+
 
 bool
 mw::cast_sight(const circle &src, const circle &circ, sight &res) noexcept
@@ -34,6 +38,17 @@ mw::cast_sight(const circle &src, const circle &circ, sight &res) noexcept
     //r = src.radius;
   //}
   //else
+#ifdef MW_VISION_PSEUDO_ANGLES
+  // directions of the tangents: rotate dO by -+asin(circ.radius/|dO|)
+  const double d = sqrt(dO2);
+  const double c = r/d, s = circ.radius/d;
+  const vec2d_d u1 = {(dO.x*c + dO.y*s)/d, (dO.y*c - dO.x*s)/d};
+  const vec2d_d u2 = {(dO.x*c - dO.y*s)/d, (dO.y*c + dO.x*s)/d};
+  res.phi1 = sight_angle(u1);
+  res.phi2 = sight_angle(u2);
+  res.sight_data.circle.cphi1 = dirangle(src.center + r*u1 - circ.center);
+  res.sight_data.circle.cphi2 = dirangle(src.center + r*u2 - circ.center);
+#else
     dphi = fabs(atan2(circ.radius, r));
 
   const double dirang = dirangle(dO);
@@ -43,6 +58,7 @@ mw::cast_sight(const circle &src, const circle &circ, sight &res) noexcept
     dirangle(circle(src.center, r)(res.phi1) - circ.center);
   res.sight_data.circle.cphi2 =
     dirangle(circle(src.center, r)(res.phi2) - circ.center);
+#endif
 
   // XXX im pretty damn certain this is wrong
   //if (interval_size({res.phi1, res.phi2}) > M_PI)
@@ -56,6 +72,44 @@ mw::cast_sight(const circle &src, const circle &circ, sight &res) noexcept
   return true;
 }
 
+// Fill sight on a line given its visible interval [t1, t2].
+static void
+_set_line_sight(const mw::circle &src, const mw::line_segment &line, double t1,
+    double t2, mw::sight &res) noexcept
+{
+  using namespace mw;
+
+  const auto dir = [&] (double t) -> vec2d_d {
+    if (t == 0)
+      return line.origin - src.center;
+    else if (t == 1)
+      return (line.origin + line.direction) - src.center;
+    else
+      return (line.origin + t*line.direction) - src.center;
+  };
+  res.sight_data.line.t1 = t1;
+  res.phi1 = sight_angle(dir(t1));
+  res.sight_data.line.t2 = t2;
+  res.phi2 = sight_angle(dir(t2));
+
+  // segment described by [phi1, phi2] must be counter-clockwise
+  if (std::max(res.phi1, res.phi2) - std::min(res.phi1, res.phi2) > M_PI)
+  { // segment intersects Pi (phi(t) = Pi, for some t in [0, 1])
+    if (res.phi1 < res.phi2)
+    {
+      std::swap(res.phi1, res.phi2);
+      std::swap(res.sight_data.line.t1, res.sight_data.line.t2);
+    }
+  }
+  else if (res.phi1 > res.phi2)
+  {
+    std::swap(res.phi1, res.phi2);
+    std::swap(res.sight_data.line.t1, res.sight_data.line.t2);
+  }
+  res.tag = sight::line;
+  res.static_data.line = line;
+}
+
 bool
 mw::cast_sight(const circle &src, const line_segment &line, sight &res) noexcept
 {
@@ -80,138 +134,180 @@ mw::cast_sight(const circle &src, const line_segment &line, sight &res) noexcept
     std::swap(t1, t2);
 
   /* t1 < t2 */
-  const vec2d_d dir1 = line.origin - src.center;
-  const vec2d_d dir2 = (line.origin + line.direction) - src.center;
-  if (t1 < 0)
-  {
-    if (t2 < 0)
-      // too far
-      return false;
-    else if (1 < t2)
-    { // both ends visible
-      res.sight_data.line.t1 = 0;
-      res.phi1 = dirangle(dir1);
-      // --
-      res.sight_data.line.t2 = 1;
-      res.phi2 = dirangle(dir2);
-    }
-    else /* 0 < t2 < 1 */
-    { // line origin is visible, the other end is too far
-      res.sight_data.line.t1 = 0;
-      res.phi1 = dirangle(dir1);
-      // --
-      const vec2d_d dir2 = (line.origin + t2*line.direction) - src.center;
-      res.sight_data.line.t2 = t2;
-      res.phi2 = dirangle(dir2);
-    }
-  }
-  else if (t1 < 1)
-  {
-    if (t2 < 1)
-    { // line crosses the circle but both ends are invisible
-      const vec2d_d dir1 = (line.origin + t1*line.direction) - src.center;
-      res.sight_data.line.t1 = t1;
-      res.phi1 = dirangle(dir1);
-      // --
-      const vec2d_d dir2 = (line.origin + t2*line.direction) - src.center;
-      res.sight_data.line.t2 = t2;
-      res.phi2 = dirangle(dir2);
-    }
-    else /* 1 < t2 */
-    { // line origin is too far, but the other end is visible
-      const vec2d_d dir1 = (line.origin + t1*line.direction) - src.center;
-      res.sight_data.line.t1 = t1;
-      res.phi1 = dirangle(dir1);
-      // --
-      res.sight_data.line.t2 = 1;
-      res.phi2 = dirangle(dir2);
-    }
-  }
-  else /* 1 < t1,2 */
+  if (t2 < 0 or not (t1 < 1))
     // too far
     return false;
 
-  // segment described by [phi1, phi2] must be counter-clockwise
-  if (std::max(res.phi1, res.phi2) - std::min(res.phi1, res.phi2) > M_PI)
-  { // segment intersects Pi (phi(t) = Pi, for some t in [0, 1])
-    if (res.phi1 < res.phi2)
+  // clip to the visible part of the line segment
+  _set_line_sight(src, line, t1 < 0 ? 0 : t1, 1 < t2 ? 1 : t2, res);
+  return true;
+}
+
+#if defined(__AVX__) || defined(__SSE2__)
+namespace {
+
+using V = mw::simd_ops;
+using vtype = V::type;
+
+// Clip lines [i, i + width) of the batch to the circle; returns mask of lines
+// within the circle.
+inline int
+_clip_lines(double cx_, double cy_, double r_, const mw::segment_batch &segs,
+    size_t i, double *t1out, double *t2out)
+{
+  const vtype zero = V::set1(0.), one = V::set1(1.);
+  const vtype cx = V::set1(cx_), cy = V::set1(cy_), r = V::set1(r_);
+  const vtype dx = V::load(segs.dx.data() + i), dy = V::load(segs.dy.data() + i);
+  const vtype Ox = V::sub(V::load(segs.ox.data() + i), cx);
+  const vtype Oy = V::sub(V::load(segs.oy.data() + i), cy);
+  const vtype dOd = V::add(V::mul(Ox, dx), V::mul(Oy, dy));
+  const vtype d2 = V::add(V::mul(dx, dx), V::mul(dy, dy));
+  const vtype dO2 = V::add(V::mul(Ox, Ox), V::mul(Oy, Oy));
+  const vtype D =
+    V::sub(V::mul(dOd, dOd), V::mul(d2, V::sub(dO2, V::mul(r, r))));
+  const vtype root = V::sqrt(V::max(D, zero));
+  const vtype t1 = V::div(V::sub(V::sub(zero, dOd), root), d2);
+  const vtype t2 = V::div(V::add(V::sub(zero, dOd), root), d2);
+  const vtype hit = V::bit_and(V::ge(D, zero),
+      V::bit_and(V::ge(t2, zero), V::lt(t1, one)));
+  V::store(t1out, V::max(t1, zero));
+  V::store(t2out, V::min(t2, one));
+  return V::mask(hit);
+}
+
+} // anonymous namespace
+#endif
+
+void
+mw::cast_sights(const circle &src, const segment_batch &segs,
+    sight_container &out)
+{
+  const size_t n = segs.size();
+  size_t i = 0;
+
+#if defined(__AVX__) || defined(__SSE2__)
+  double t1[V::width], t2[V::width];
+  for (; i + V::width <= n; i += V::width)
+  {
+    const int hits = _clip_lines(src.center.x, src.center.y, src.radius, segs,
+        i, t1, t2);
+    for (size_t k = 0; hits and k < V::width; ++k)
     {
-      std::swap(res.phi1, res.phi2);
-      std::swap(res.sight_data.line.t1, res.sight_data.line.t2);
+      if (not (hits & (1 << k)))
+        continue;
+      sight &s = out.emplace_back();
+      _set_line_sight(src, segs[i + k], t1[k], t2[k], s);
+      s.static_data.aux_data = uint64_t(i + k);
     }
   }
-  else if (res.phi1 > res.phi2)
+#endif
+
+  for (; i < n; ++i)
   {
-    std::swap(res.phi1, res.phi2);
-    std::swap(res.sight_data.line.t1, res.sight_data.line.t2);
+    sight s;
+    if (cast_sight(src, segs[i], s))
+    {
+      s.static_data.aux_data = uint64_t(i);
+      out.push_back(s);
+    }
   }
-  res.tag = sight::line;
-  res.static_data.line = line;
-  return true;
 }
 
+// Sights processed pairwise are stripped of their geometry, which is looked up
+// in the sight they originate from (see vision_processor::process()).
+namespace {
+
+struct compact_sight {
+  double phi1, phi2;
+  mw::sight::sight_data_type sight_data;
+  const mw::sight *origin;
+};
+static_assert(sizeof(compact_sight) == 40);
+
+inline const mw::sight::static_data_type&
+_geom(const mw::sight &s) noexcept
+{ return s.static_data; }
+
+inline const mw::sight::static_data_type&
+_geom(const compact_sight &s) noexcept
+{ return s.origin->static_data; }
+
+inline mw::sight::tag_type
+_tag(const mw::sight &s) noexcept
+{ return s.tag; }
+
+inline mw::sight::tag_type
+_tag(const compact_sight &s) noexcept
+{ return s.origin->tag; }
+
+} // anonymous namespace
+
 /* XXX: this function assumes that sights overlap */
+template <typename A, typename B>
 static inline bool
-_is_circle_before_circle(const mw::pt2d_d &source, const mw::sight& a,
-    const mw::sight &b) noexcept
+_is_circle_before_circle(const mw::pt2d_d &source, const A &a,
+    const B &b) noexcept
 {
-  const double r12 = mag2(a.static_data.circle.center - source);
-  const double r22 = mag2(b.static_data.circle.center - source);
+  const double r12 = mag2(_geom(a).circle.center - source);
+  const double r22 = mag2(_geom(b).circle.center - source);
   return r12 < r22;
 }
 
 /* XXX: this function assumes that sights overlap */
+template <typename A, typename B>
 static bool
-_is_circle_before_line(const mw::pt2d_d &source, const mw::sight& a,
-    const mw::sight &b) noexcept
+_is_circle_before_line(const mw::pt2d_d &source, const A &a,
+    const B &b) noexcept
 {
   using namespace mw;
 
-  const line_segment &line = b.static_data.line;
+  const line_segment &line = _geom(b).line;
   const pt2d_d p1 = line.origin + b.sight_data.line.t1*line.direction;
   const pt2d_d p2 = line.origin + b.sight_data.line.t2*line.direction;
   const double p1r2 = mag2(p1 - source);
   const double p2r2 = mag2(p2 - source);
-  const pt2d_d r1 = a.static_data.circle(a.sight_data.circle.cphi1);
-  const pt2d_d r2 = a.static_data.circle(a.sight_data.circle.cphi2);
+  const pt2d_d r1 = _geom(a).circle(a.sight_data.circle.cphi1);
+  const pt2d_d r2 = _geom(a).circle(a.sight_data.circle.cphi2);
   const double r12 = mag2(r1 - source);
   const double r22 = mag2(r2 - source);
   if (contains_inc({a.phi1, a.phi2}, b.phi1))
   {
     const line_segment ray {
       source,
-      b.static_data.line(b.sight_data.line.t1) - source
+      _geom(b).line(b.sight_data.line.t1) - source
     };
     double _;
-    return intersect(ray, a.static_data.circle, _) > 0;
+    return intersect(ray, _geom(a).circle, _) > 0;
   }
   else if (contains_inc({a.phi1, a.phi2}, b.phi2))
   {
     const line_segment ray {
       source,
-      b.static_data.line(b.sight_data.line.t2) - source
+      _geom(b).line(b.sight_data.line.t2) - source
     };
     double _;
-    return intersect(ray, a.static_data.circle, _) > 0;
+    return intersect(ray, _geom(a).circle, _) > 0;
   }
   else
   {
-    const line_segment ray {source, a.static_data.circle.center - source};
+    const line_segment ray {source, _geom(a).circle.center - source};
     double _;
-    return not (intersect(ray, b.static_data.line, _, _) > 0);
+    return not (intersect(ray, _geom(b).line, _, _) > 0);
   }
 }
 
 /* XXX: this function assumes that sights overlap */
+template <typename A, typename B>
 static inline bool
-_is_line_before_circle(const mw::pt2d_d &source, const mw::sight& a,
-    const mw::sight &b) noexcept
+_is_line_before_circle(const mw::pt2d_d &source, const A &a,
+    const B &b) noexcept
 { return not _is_circle_before_line(source, b, a); }
 
 /* XXX: this function assumes that sights overlap */
+template <typename A, typename B>
 static bool
-_is_line_before_line(const mw::pt2d_d &source, const mw::sight& a,
-    const mw::sight &b) noexcept
+_is_line_before_line(const mw::pt2d_d &source, const A &a,
+    const B &b) noexcept
 {
   using namespace mw;
 
@@ -220,28 +316,28 @@ _is_line_before_line(const mw::pt2d_d &source, const mw::sight& a,
     // intersects `a`.
     const line_segment ray {
       source,
-      b.static_data.line(b.sight_data.line.t1)-source
+      _geom(b).line(b.sight_data.line.t1)-source
     };
     double _;
-    return intersect(ray, a.static_data.line, _, _) > 0;
+    return intersect(ray, _geom(a).line, _, _) > 0;
   }
   else if (contains({a.phi1, a.phi2}, b.phi2))
   { // draw a line from source to the second point on `b` and check if it
     // intersects `a`.
     const line_segment ray {
       source,
-      b.static_data.line(b.sight_data.line.t2)-source
+      _geom(b).line(b.sight_data.line.t2)-source
     };
     double _;
-    return intersect(ray, a.static_data.line, _, _) > 0;
+    return intersect(ray, _geom(a).line, _, _) > 0;
   }
   else if (a.phi1 == b.phi1 and a.phi2 == b.phi2)
   {
     const double tbcenter = (b.sight_data.line.t1 + b.sight_data.line.t2)/2;
-    const pt2d_d bcenter = b.static_data.line(tbcenter);
+    const pt2d_d bcenter = _geom(b).line(tbcenter);
     const line_segment ray {source, bcenter - source};
     double t1, t2;
-    const int ret = intersect(ray, a.static_data.line, t1, t2);
+    const int ret = intersect(ray, _geom(a).line, t1, t2);
     return ret > 0;
   }
   else
@@ -292,10 +388,10 @@ mw::study_box(const pt2d_d &src, const rectangle &box, box_info &res)
   res.ur = box.offset + vec2d_d {box.width, box.height};
   res.dr = box.offset + vec2d_d {box.width, 0};
   res.dl = box.offset + vec2d_d {0, 0};
-  res.ulang = dirangle(res.ul - src);
-  res.urang = dirangle(res.ur - src);
-  res.drang = dirangle(res.dr - src);
-  res.dlang = dirangle(res.dl - src);
+  res.ulang = sight_angle(res.ul - src);
+  res.urang = sight_angle(res.ur - src);
+  res.drang = sight_angle(res.dr - src);
+  res.dlang = sight_angle(res.dl - src);
   res.sectors[0] = {res.drang, res.urang};
   res.sectors[1] = {res.urang, res.ulang};
   res.sectors[2] = {res.ulang, res.dlang};
@@ -349,7 +445,7 @@ mw::study_box(const pt2d_d &src, const rectangle &box, box_info &res)
 void
 mw::cast_shadows_in_the_box(const pt2d_d &src, const line_segment &line, double t1,
     double t2, double phi1, double phi2, const rectangle &box,
-    const box_info &boxinfo, std::vector<pt2d_d> &out)
+    const box_info &boxinfo, vision_vector<pt2d_d> &out)
 {
   const pt2d_d a = line(t1);
   const pt2d_d b = line(t2);
@@ -358,8 +454,8 @@ mw::cast_shadows_in_the_box(const pt2d_d &src, const line_segment &line, double
   int bsec = -1;
   for (int i = 0; i < 4; ++i)
   {
-    if (contains_inc(boxinfo.sectors[i], dirangle(a - src))) asec = i;
-    if (contains_inc(boxinfo.sectors[i], dirangle(b - src))) bsec = i;
+    if (contains_inc(boxinfo.sectors[i], sight_angle(a - src))) asec = i;
+    if (contains_inc(boxinfo.sectors[i], sight_angle(b - src))) bsec = i;
   }
   if (asec < 0 or bsec < 0)
   {
@@ -399,7 +495,7 @@ mw::cast_shadows_in_the_box(const pt2d_d &src, const line_segment &line, double
 void
 mw::cast_shadows_on_the_box(const pt2d_d &src, const line_segment &line_,
     double t1, double t2, double phi1, double phi2, const rectangle &box,
-    const box_info &boxinfo, std::vector<pt2d_d> &out)
+    const box_info &boxinfo, vision_vector<pt2d_d> &out)
 {
   const pt2d_d a = line_(t1);
   const pt2d_d b = line_(t2);
@@ -469,93 +565,105 @@ mw::cast_shadows_on_the_box(const pt2d_d &src, const line_segment &line_,
 
   const pt2d_d center = {xsum/out.size(), ysum/out.size()};
   std::sort(out.begin(), out.end(), [&] (const pt2d_d &a, const pt2d_d &b) {
-    return dirangle(a - center) < dirangle(b - center);
+    return sight_angle(a - center) < sight_angle(b - center);
   });
 }
 
-bool
-mw::is_before(const pt2d_d &source, const sight &a, const sight &b)
+template <typename A, typename B>
+static bool
+_is_before(const mw::pt2d_d &source, const A &a, const B &b)
 {
-  switch (a.tag)
+  using namespace mw;
+
+  switch (_tag(a))
   {
     case sight::circle:
-      switch (b.tag)
+      switch (_tag(b))
       {
         case sight::circle: return _is_circle_before_circle(source, a, b);
         case sight::line: return _is_circle_before_line(source, a, b);
       }
-      throw std::logic_error {(boost::format("undefined sight b:%d") % b.tag).str()};
+      throw std::logic_error {(boost::format("undefined sight b:%d") % _tag(b)).str()};
     // end case circle
     case sight::line:
-      switch (b.tag)
+      switch (_tag(b))
       {
         case sight::circle: return _is_line_before_circle(source, a, b);
         case sight::line: return _is_line_before_line(source, a, b);
       }
-      throw std::logic_error {(boost::format("undefined sight b:%d") % b.tag).str()};
+      throw std::logic_error {(boost::format("undefined sight b:%d") % _tag(b)).str()};
     // end case line
   }
-  throw std::logic_error {(boost::format("undefined sight a:%d") % a.tag).str()};
+  throw std::logic_error {(boost::format("undefined sight a:%d") % _tag(a)).str()};
 }
 
+bool
+mw::is_before(const pt2d_d &source, const sight &a, const sight &b)
+{ return _is_before(source, a, b); }
+
+template <typename S>
 static void
-_adjust_line_sight(const mw::pt2d_d &source, mw::sight &s, double phi1,
+_adjust_line_sight(const mw::pt2d_d &source, S &s, double phi1,
                    double phi2)
 {
   using namespace mw;
 
   if (phi1 != s.phi1)
   {
-    const line_segment ray {source, rotated(vec2d_d(1, 0), phi1)};
+    const line_segment ray {source, sight_direction(phi1)};
     double rayt, linet;
     // we know there MUST be intersection
-    intersect(ray, s.static_data.line, rayt, linet);
+    intersect(ray, _geom(s).line, rayt, linet);
     s.phi1 = phi1;
     s.sight_data.line.t1 = linet;
   }
 
   if (phi2 != s.phi2)
   {
-    const line_segment ray {source, rotated(vec2d_d(1, 0), phi2)};
+    const line_segment ray {source, sight_direction(phi2)};
     double rayt, linet;
     // we know there MUST be intersection
-    intersect(ray, s.static_data.line, rayt, linet);
+    intersect(ray, _geom(s).line, rayt, linet);
     s.phi2 = phi2;
     s.sight_data.line.t2 = linet;
   }
 }
 
+template <typename S>
 static void
-_adjust_circle_sight(const mw::pt2d_d &source, mw::sight &s, double phi1,
+_adjust_circle_sight(const mw::pt2d_d &source, S &s, double phi1,
                      double phi2)
 {
   using namespace mw;
 
   if (phi1 != s.phi1)
   {
-    const line_segment ray {source, rotated(vec2d_d(1, 0), phi1)};
+    const line_segment ray {source, sight_direction(phi1)};
     double t;
     // we know there MUST be intersection
-    intersect(ray, s.static_data.circle, t);
+    intersect(ray, _geom(s).circle, t);
     s.phi1 = phi1;
-    s.sight_data.circle.cphi1 = dirangle(ray(t) - s.static_data.circle.center);
+    s.sight_data.circle.cphi1 = dirangle(ray(t) - _geom(s).circle.center);
   }
 
   if (phi2 != s.phi2)
   {
-    const line_segment ray {source, rotated(vec2d_d(1, 0), phi2)};
+    const line_segment ray {source, sight_direction(phi2)};
     double t;
     // we know there MUST be intersection
-    intersect(ray, s.static_data.circle, t);
+    intersect(ray, _geom(s).circle, t);
     s.phi2 = phi2;
-    s.sight_data.circle.cphi2 = dirangle(ray(t) - s.static_data.circle.center);
+    s.sight_data.circle.cphi2 = dirangle(ray(t) - _geom(s).circle.center);
   }
 }
 
-void
-mw::adjust_sight(const circle &source, sight &s, double phi1, double phi2)
+template <typename S>
+static void
+_adjust_sight(const mw::circle &source, S &s, double phi1, double phi2)
 {
-  switch (s.tag)
+  using namespace mw;
+
+  switch (_tag(s))
   {
     case sight::circle:
       _adjust_circle_sight(source.center, s, phi1, phi2);
@@ -566,15 +674,16 @@ mw::adjust_sight(const circle &source, sight &s, double phi1, double phi2)
       break;
 
     default:
-      throw std::logic_error {(boost::format("undefined sight s:%d") % s.tag).str()};
+      throw std::logic_error {(boost::format("undefined sight s:%d") % _tag(s)).str()};
   }
 }
 
+void
+mw::adjust_sight(const circle &source, sight &s, double phi1, double phi2)
+{ _adjust_sight(source, s, phi1, phi2); }
+
 
 
-void
-mw::vision_processor::_load_obstacle(const vis_obstacle *obs)
-{ obs->get_sights(*this); }
 
 
 template <
@@ -593,15 +702,15 @@ _process(const mw::circle &source,
 
   for (TIter tit = tbegin; tit != tend; ++tit)
   {
-    sight &ts = *tit;
+    compact_sight &ts = *tit;
 
     for (AIter ait = abegin; ait != aend; ++ait)
     {
       const sight &as = *ait;
       if (as.is_transparent) continue;
-      if (same_identity(as, ts)) continue;
       if (not overlaps({ts.phi1, ts.phi2}, {as.phi1, as.phi2})) continue;
-      if (not is_before(source.center, as, ts)) continue;
+      if (same_identity(as, *ts.origin)) continue;
+      if (not _is_before(source.center, as, ts)) continue;
 
       double newphi1 = ts.phi1;
       double newphi2 = ts.phi2;
@@ -615,13 +724,13 @@ _process(const mw::circle &source,
           break;
 
         case adjust:
-          adjust_sight(source, ts, newphi1, newphi2);
+          _adjust_sight(source, ts, newphi1, newphi2);
           break;
 
         case split: {
-          sight s1copy = ts;
-          adjust_sight(source, ts, ts.phi1, newphi1);
-          adjust_sight(source, s1copy, newphi2, s1copy.phi2);
+          compact_sight s1copy = ts;
+          _adjust_sight(source, ts, ts.phi1, newphi1);
+          _adjust_sight(source, s1copy, newphi2, s1copy.phi2);
           *newsights = s1copy;
           break;
         }
@@ -630,6 +739,31 @@ _process(const mw::circle &source,
   }
 }
 
+static void
+_compact_sights(const mw::sight_container &in,
+    mw::vision_vector<compact_sight> &out)
+{
+  out.clear();
+  out.reserve(in.size());
+  for (const mw::sight &s : in)
+    out.push_back({s.phi1, s.phi2, s.sight_data, &s});
+}
+
+static void
+_expand_sights(const mw::vision_vector<compact_sight> &in,
+    mw::sight_container &out)
+{
+  out.clear();
+  out.reserve(in.size());
+  for (const compact_sight &c : in)
+  {
+    mw::sight &s = out.emplace_back(*c.origin);
+    s.phi1 = c.phi1;
+    s.phi2 = c.phi2;
+    s.sight_data = c.sight_data;
+  }
+}
+
 template <typename Container>
 class swapback_eraser {
   public:
@@ -650,12 +784,652 @@ class swapback_eraser {
   Container &m_container;
 };
 
+// Angular sweep
+// -------------
+// Sight intervals are cut at -pi/pi, and their ends are sorted by angle.
+// Between two consecutive ends the set of sights covering the direction stays
+// the same, so the visible ones are the nearest opaque sight at the middle of
+// the interval and transparent sights before it. Active opaque and transparent
+// sights are kept in two heaps ordered by distance along the ray, so each end
+// costs O(log k) for k active sights; as obstacles may cross each other (e.g.
+// an NPC touching a wall), a heap is rebuilt whenever its top turns out
+// misplaced.
+//
+// Incremental passes start from the sorted ends of the previous pass. When the
+// same sights are loaded again (from a slightly moved source) the ends are
+// mostly in order already, and an insertion sort restores it at the cost of
+// the ends that moved. An interval preceded by exactly the ends that preceded
+// it the last time covers the same sights, and for sights that can not cross
+// each other the nearest one stays the same; visible sights of such intervals
+// are just repeated. Circles, sights on moved obstacles, and lines the source
+// passed across are not trusted this way.
+
+namespace {
+
+struct sweep_event {
+  double phi;
+  uint32_t isight;
+  // position of this end in the previous pass
+  uint32_t prevpos;
+  bool is_start;
+  // ends of a sight: 0/1 for [phi1, phi2] (or [phi1, pi]), 2/3 for [-pi, phi2]
+  uint8_t part;
+
+  bool
+  operator < (const sweep_event &other) const noexcept
+  {
+    if (phi != other.phi)
+      return phi < other.phi;
+    // close intervals before opening new ones
+    return is_start < other.is_start;
+  }
+};
+
+struct sweep_piece {
+  uint32_t isight;
+  double phi1, phi2;
+};
+
+// range of sights visible within an interval following some end
+struct sweep_gap {
+  uint32_t begin, end;
+};
+constexpr sweep_gap no_sweep_gap = {UINT32_MAX, UINT32_MAX};
+
+// Fraction of ends which may be shifted to restore their order in an
+// incremental pass before it falls back to a full one.
+constexpr double incremental_sweep_limit = 0.125;
+
+// Parts of the sweep_event's of S which are present (bitmask).
+unsigned
+_sweep_parts(const mw::sight &s) noexcept
+{
+  if (not std::isfinite(s.phi1) or not std::isfinite(s.phi2))
+    return 0;
+  if (s.phi1 == s.phi2)
+    return 0;
+  if (s.phi1 < s.phi2)
+    return 0b0011;
+  // crossing pi (either part may be empty when an end lies on pi)
+  return (s.phi1 < +M_PI ? 0b0011 : 0) | (-M_PI < s.phi2 ? 0b1100 : 0);
+}
+
+sweep_event
+_sweep_event(const mw::sight &s, uint32_t isight, uint8_t part) noexcept
+{
+  switch (part)
+  {
+    case 0: return {s.phi1, isight, 0, true, part};
+    case 1: return {s.phi1 < s.phi2 ? s.phi2 : +M_PI, isight, 0, false, part};
+    case 2: return {-M_PI, isight, 0, true, part};
+    default: return {s.phi2, isight, 0, false, part};
+  }
+}
+
+// Side of the line of sight S the source lies on.
+bool
+_sweep_side(const mw::pt2d_d &source, const mw::sight &s) noexcept
+{
+  const mw::line_segment &l = s.static_data.line;
+  const mw::vec2d_d w = source - l.origin;
+  return l.direction.x*w.y - l.direction.y*w.x > 0;
+}
+
+// Whether visibility of sight S, loaded in place of PREV, may be repeated from
+// the previous pass (see above).
+bool
+_sweep_trusted(const mw::pt2d_d &source, const mw::sight &s,
+    const mw::pt2d_d &prevsource, const mw::sight &prev) noexcept
+{
+  if (s.tag != mw::sight::line)
+    return false;
+  const mw::line_segment &l = s.static_data.line;
+  const mw::line_segment &pl = prev.static_data.line;
+  return l.origin == pl.origin and l.direction == pl.direction
+     and _sweep_side(source, s) == _sweep_side(prevsource, prev);
+}
+
+// Distance from SOURCE to the obstacle of S along the ray in direction U.
+double
+_distance_along(const mw::pt2d_d &source, const mw::sight &s,
+    const mw::vec2d_d &u) noexcept
+{
+  using namespace mw;
+
+  if (s.tag == sight::line)
+  {
+    const line_segment &l = s.static_data.line;
+    const vec2d_d w = l.origin - source;
+    const vec2d_d d = l.direction;
+    return (w.x*d.y - w.y*d.x)/(u.x*d.y - u.y*d.x);
+  }
+  else
+  {
+    const circle &c = s.static_data.circle;
+    const vec2d_d w = c.center - source;
+    const double b = dot(w, u);
+    const double D = b*b - (mag2(w) - c.radius*c.radius);
+    return std::max(b - sqrt(std::max(D, 0.)), 0.);
+  }
+}
+
+// Binary heap of active sights with the nearest one on top. Sights are
+// compared along the current ray of the sweep; as long as they do not cross
+// each other their order does not depend on the ray, so the heap stays valid
+// while the sweep turns. Position of each sight in the heap is tracked to
+// drop it in O(log k).
+class sweep_heap {
+  public:
+  static constexpr uint32_t none = UINT32_MAX;
+
+  sweep_heap(mw::vision_vector<uint32_t> &items,
+      mw::vision_vector<uint32_t> &pos) noexcept
+  : m_items {items}, m_pos {pos}
+  { }
+
+  bool
+  empty() const noexcept
+  { return m_items.empty(); }
+
+  size_t
+  size() const noexcept
+  { return m_items.size(); }
+
+  uint32_t
+  top() const noexcept
+  { return m_items.front(); }
+
+  uint32_t
+  operator [] (size_t k) const noexcept
+  { return m_items[k]; }
+
+  void
+  clear() noexcept
+  { m_items.clear(); }
+
+  template <typename Less> void
+  push(uint32_t i, Less &&less)
+  {
+    m_items.push_back(i);
+    m_pos[i] = m_items.size() - 1;
+    _sift_up(m_items.size() - 1, less);
+  }
+
+  template <typename Less> void
+  erase(uint32_t i, Less &&less)
+  {
+    const size_t k = m_pos[i];
+    m_pos[i] = none;
+    const uint32_t last = m_items.back();
+    m_items.pop_back();
+    if (k == m_items.size())
+      return;
+    m_items[k] = last;
+    m_pos[last] = k;
+    _sift_up(k, less);
+    _sift_down(m_pos[last], less);
+  }
+
+  // whether the top is nearer then both of its children
+  template <typename Less> bool
+  is_top_valid(Less &&less) const
+  {
+    for (size_t c = 1; c <= 2 and c < m_items.size(); ++c)
+    {
+      if (less(m_items[c], m_items[0]))
+        return false;
+    }
+    return true;
+  }
+
+  template <typename Less> void
+  rebuild(Less &&less)
+  {
+    for (size_t k = m_items.size()/2; k-- > 0;)
+      _sift_down(k, less);
+  }
+
+  private:
+  template <typename Less> void
+  _sift_up(size_t k, Less &&less)
+  {
+    const uint32_t i = m_items[k];
+    while (k > 0)
+    {
+      const size_t parent = (k - 1)/2;
+      if (not less(i, m_items[parent]))
+        break;
+      m_items[k] = m_items[parent];
+      m_pos[m_items[k]] = k;
+      k = parent;
+    }
+    m_items[k] = i;
+    m_pos[i] = k;
+  }
+
+  template <typename Less> void
+  _sift_down(size_t k, Less &&less)
+  {
+    const size_t n = m_items.size();
+    const uint32_t i = m_items[k];
+    while (true)
+    {
+      size_t c = 2*k + 1;
+      if (c >= n)
+        break;
+      if (c + 1 < n and less(m_items[c + 1], m_items[c]))
+        c += 1;
+      if (not less(m_items[c], i))
+        break;
+      m_items[k] = m_items[c];
+      m_pos[m_items[k]] = k;
+      k = c;
+    }
+    m_items[k] = i;
+    m_pos[i] = k;
+  }
+
+  mw::vision_vector<uint32_t> &m_items;
+  mw::vision_vector<uint32_t> &m_pos;
+};
+
+} // anonymous namespace
+
+/** @brief Buffers of a vision processor reused between passes. */
+struct mw::vision_scratch {
+  // pairwise passes
+  vision_vector<compact_sight> tsights, nsights, osights;
+  sight_container sights;
+  // angular sweep
+  vision_vector<sweep_event> events;
+  vision_vector<uint32_t> opaque, transparent, heappos;
+  vision_vector<uint32_t> starting, seen, stack;
+  vision_vector<double> run1, run2;
+  vision_vector<sweep_piece> pieces;
+  vision_vector<int> head, tail;
+  // incremental angular sweep
+  std::optional<circle> prev_source;
+  sight_container prev_input;
+  vision_vector<sweep_event> prev_events;
+  vision_vector<sweep_gap> gaps, prev_gaps;
+  vision_vector<uint32_t> visible, prev_visible;
+  vision_vector<uint8_t> trusted;
+  // vis-obstacles of a map
+  vis_obstacle_list obstacles;
+  // line segments queued by load_obstacles(), with their obstacles and indices
+  // within them
+  segment_batch lines;
+  vision_vector<const vis_obstacle*> line_owners;
+  vision_vector<uint32_t> line_indices;
+  // shadow polygons
+  vision_vector<pt2d_d> points;
+  shadow_mesh shadows;
+};
+
+void
+mw::vision_scratch_deleter::operator () (vision_scratch *scratch) const noexcept
+{ delete scratch; }
+
+mw::vision_scratch&
+mw::vision_processor::_scratch() const
+{
+  if (not m_scratch)
+    m_scratch.reset(new vision_scratch);
+  return *m_scratch;
+}
+
+void
+mw::vision_processor::_load_obstacle(const vis_obstacle *obs)
+{
+  const segment_batch *segs = obs->get_sight_segments();
+  if (segs == nullptr)
+  {
+    obs->get_sights(*this);
+    return;
+  }
+
+  // cast later along with segments of other obstacles
+  vision_scratch &scratch = _scratch();
+  for (size_t i = 0; i < segs->size(); ++i)
+  {
+    scratch.lines.push_back((*segs)[i]);
+    scratch.line_owners.push_back(obs);
+    scratch.line_indices.push_back(i);
+  }
+}
+
+void
+mw::vision_processor::_flush_line_sights()
+{
+  if (not m_scratch or m_scratch->lines.size() == 0)
+    return;
+
+  // segments of all the obstacles go in a single batch, so that vectorized
+  // kernels get enough of them even for single-segment walls
+  vision_scratch &scratch = *m_scratch;
+  const size_t first = m_sights.size();
+  cast_sights(get_source(), scratch.lines, m_sights);
+  for (size_t i = first; i < m_sights.size(); ++i)
+  {
+    sight &s = m_sights[i];
+    const size_t k = s.static_data.aux_data.u64;
+    s.static_data.obs = scratch.line_owners[k];
+    s.static_data.aux_data = uint64_t(scratch.line_indices[k]);
+  }
+  scratch.lines.clear();
+  scratch.line_owners.clear();
+  scratch.line_indices.clear();
+}
+
+void
+mw::vision_processor::load_obstacles(const area_map &map)
+{
+  vis_obstacle_list &obstacles = _scratch().obstacles;
+  map.collect_vis_obstacles(get_source(), obstacles);
+  load_obstacles(obstacles);
+}
+
+namespace {
+
+void
+_sweep(const mw::circle &source, mw::sight_container &sights,
+    mw::vision_scratch &scratch, bool incremental)
+{
+  using namespace mw;
+
+  const size_t n = sights.size();
+  sight_container &out = scratch.sights;
+  out.clear();
+
+  for (const sight &s : sights)
+  {
+    // keep broken sights as they are
+    if (not std::isfinite(s.phi1) or not std::isfinite(s.phi2))
+      out.push_back(s);
+  }
+
+  // can we start from the previous pass?
+  const sight_container &prev = scratch.prev_input;
+  vision_vector<uint8_t> &trusted = scratch.trusted;
+  bool reuse = incremental and scratch.prev_source.has_value() and
+    scratch.prev_source->radius == source.radius and prev.size() == n;
+  if (reuse)
+  {
+    trusted.resize(n);
+    const pt2d_d &prevcenter = scratch.prev_source->center;
+    for (size_t i = 0; reuse and i < n; ++i)
+    {
+      const sight &s = sights[i], &p = prev[i];
+      reuse = same_identity(s, p) and s.tag == p.tag and
+        s.is_transparent == p.is_transparent and
+        _sweep_parts(s) == _sweep_parts(p);
+      trusted[i] = _sweep_trusted(source.center, s, prevcenter, p);
+    }
+  }
+
+  vision_vector<sweep_event> &events = scratch.events;
+  events.clear();
+  if (reuse)
+  {
+    // ends in the order of the previous pass
+    const vision_vector<sweep_event> &prevevents = scratch.prev_events;
+    events.reserve(prevevents.size());
+    for (size_t k = 0; k < prevevents.size(); ++k)
+    {
+      const sweep_event &pev = prevevents[k];
+      sweep_event ev = _sweep_event(sights[pev.isight], pev.isight, pev.part);
+      ev.prevpos = k;
+      events.push_back(ev);
+    }
+
+    // insertion sort until too many ends turn out to be out of order
+    const size_t maxshifts = events.size()*incremental_sweep_limit + 8;
+    size_t nshifts = 0;
+    for (size_t k = 1; reuse and k < events.size(); ++k)
+    {
+      const sweep_event ev = events[k];
+      size_t j = k;
+      for (; j > 0 and ev < events[j-1]; --j)
+        events[j] = events[j-1];
+      events[j] = ev;
+      nshifts += k - j;
+      reuse = nshifts <= maxshifts;
+    }
+    if (not reuse)
+      std::sort(events.begin(), events.end());
+  }
+  else
+  {
+    events.reserve(n*2);
+    for (size_t i = 0; i < n; ++i)
+    {
+      const unsigned parts = _sweep_parts(sights[i]);
+      for (uint8_t part = 0; part < 4; ++part)
+      {
+        if (parts & (1 << part))
+          events.push_back(_sweep_event(sights[i], i, part));
+      }
+    }
+    std::sort(events.begin(), events.end());
+  }
+
+  // visible sights of intervals following each end, for the next pass
+  const vision_vector<sweep_gap> &prevgaps = scratch.prev_gaps;
+  const vision_vector<uint32_t> &prevvisible = scratch.prev_visible;
+  vision_vector<sweep_gap> &gaps = scratch.gaps;
+  vision_vector<uint32_t> &visible = scratch.visible;
+  gaps.clear();
+  visible.clear();
+  if (incremental)
+    gaps.assign(events.size() + 1, no_sweep_gap);
+
+  sweep_heap opaque {scratch.opaque, scratch.heappos};
+  sweep_heap transparent {scratch.transparent, scratch.heappos};
+  scratch.heappos.assign(n, sweep_heap::none);
+  opaque.clear();
+  transparent.clear();
+  vision_vector<uint32_t> &starting = scratch.starting;
+  vision_vector<uint32_t> &seen = scratch.seen;
+  vision_vector<uint32_t> &stack = scratch.stack;
+  // latest previous position of the ends passed so far
+  uint32_t maxprevpos = 0;
+  // number of active sights which are not trusted
+  size_t nuntrusted = 0;
+  // currently open visible part of each sight
+  vision_vector<double> &run1 = scratch.run1, &run2 = scratch.run2;
+  run1.assign(n, NAN);
+  run2.assign(n, NAN);
+  vision_vector<sweep_piece> &pieces = scratch.pieces;
+  pieces.clear();
+  // parts of sights crossing pi: the one starting at -pi and ending at pi
+  vision_vector<int> &head = scratch.head, &tail = scratch.tail;
+  head.assign(n, -1);
+  tail.assign(n, -1);
+
+  const auto flush = [&] (uint32_t i) {
+    if (std::isnan(run1[i]))
+      return;
+    if (run1[i] == -M_PI)
+      head[i] = pieces.size();
+    if (run2[i] == +M_PI)
+      tail[i] = pieces.size();
+    pieces.push_back({i, run1[i], run2[i]});
+    run1[i] = run2[i] = NAN;
+  };
+
+  const auto see = [&] (uint32_t i, double a, double b) {
+    if (run2[i] != a)
+    {
+      flush(i);
+      run1[i] = a;
+    }
+    run2[i] = b;
+  };
+
+  // ray in the middle of the last interval (all active sights cover it)
+  vec2d_d u = {1, 0};
+  const auto dist = [&] (uint32_t i) {
+    return _distance_along(source.center, sights[i], u);
+  };
+  const auto closer = [&] (uint32_t i, uint32_t j) {
+    const double di = dist(i), dj = dist(j);
+    return di < dj or (di == dj and i < j);
+  };
+
+  for (size_t iev = 0; iev < events.size();)
+  {
+    // apply all events at this angle; sights are dropped while U still
+    // points in between all of the active ones
+    const double a = events[iev].phi;
+    starting.clear();
+    for (; iev < events.size() and events[iev].phi == a; ++iev)
+    {
+      const sweep_event &ev = events[iev];
+      if (ev.is_start)
+        starting.push_back(ev.isight);
+      else if (sights[ev.isight].is_transparent)
+        transparent.erase(ev.isight, closer);
+      else
+        opaque.erase(ev.isight, closer);
+      if (reuse)
+      {
+        maxprevpos = std::max(maxprevpos, ev.prevpos);
+        if (not trusted[ev.isight] and ev.is_start)
+          nuntrusted += 1;
+        else if (not trusted[ev.isight])
+          nuntrusted -= 1;
+      }
+    }
+    if (iev == events.size())
+      break;
+
+    // order sights along the ray in the middle of the next interval
+    const double b = events[iev].phi;
+    u = sight_direction((a + b)/2);
+    for (const uint32_t i : starting)
+    {
+      if (sights[i].is_transparent)
+        transparent.push(i, closer);
+      else
+        opaque.push(i, closer);
+    }
+    // obstacles crossing each other (e.g. an NPC touching a wall) break the
+    // order; re-establish it whenever the nearest sight turns out misplaced
+    if (not opaque.is_top_valid(closer))
+      opaque.rebuild(closer);
+    if (not transparent.is_top_valid(closer))
+      transparent.rebuild(closer);
+
+    // same ends precede the interval as in the previous pass
+    if (reuse and maxprevpos + 1 == iev and nuntrusted == 0 and
+        prevgaps[iev].begin != UINT32_MAX)
+    {
+      gaps[iev].begin = visible.size();
+      for (uint32_t k = prevgaps[iev].begin; k < prevgaps[iev].end; ++k)
+      {
+        see(prevvisible[k], a, b);
+        visible.push_back(prevvisible[k]);
+      }
+      gaps[iev].end = visible.size();
+      continue;
+    }
+
+    // mark visible sights: the nearest opaque one and transparent ones before
+    // it (these form a subtree at the top of the heap)
+    seen.clear();
+    double dnearest = INFINITY;
+    if (not opaque.empty())
+    {
+      seen.push_back(opaque.top());
+      dnearest = dist(opaque.top());
+    }
+    const size_t nopaque = seen.size();
+    stack.clear();
+    if (not transparent.empty())
+      stack.push_back(0);
+    while (not stack.empty())
+    {
+      const uint32_t k = stack.back();
+      stack.pop_back();
+      const uint32_t i = transparent[k];
+      if (not (dist(i) < dnearest))
+        continue;
+      seen.push_back(i);
+      for (const uint32_t c : {2*k + 1, 2*k + 2})
+      {
+        if (c < transparent.size())
+          stack.push_back(c);
+      }
+    }
+    // keep output independent of the layout of the heap
+    std::sort(seen.begin() + nopaque, seen.end());
+
+    const size_t visbegin = visible.size();
+    for (const uint32_t i : seen)
+    {
+      see(i, a, b);
+      if (incremental)
+        visible.push_back(i);
+    }
+    if (incremental)
+      gaps[iev] = {uint32_t(visbegin), uint32_t(visible.size())};
+  }
+  for (size_t i = 0; i < n; ++i)
+    flush(i);
+
+  // glue back parts of sights crossing pi
+  for (size_t i = 0; i < n; ++i)
+  {
+    if (head[i] >= 0 and tail[i] >= 0 and head[i] != tail[i])
+    {
+      pieces[tail[i]].phi2 = pieces[head[i]].phi2;
+      pieces[head[i]].isight = n;
+    }
+  }
+
+  out.reserve(out.size() + pieces.size());
+  for (const sweep_piece &p : pieces)
+  {
+    if (p.isight == n)
+      continue;
+    sight s = sights[p.isight];
+    adjust_sight(source, s, p.phi1, p.phi2);
+    out.push_back(s);
+  }
+  std::swap(sights, out);
+
+  // remember the pass (loaded sights are now in OUT)
+  if (incremental)
+  {
+    scratch.prev_source = source;
+    std::swap(scratch.prev_input, out);
+    std::swap(scratch.prev_events, events);
+    std::swap(scratch.prev_gaps, gaps);
+    std::swap(scratch.prev_visible, visible);
+  }
+  else
+    scratch.prev_source = std::nullopt;
+}
+
+} // anonymous namespace
+
 void
 mw::vision_processor::process()
 {
-  std::vector<sight> tsights = m_sights;
-  std::vector<sight> nsights;
-  std::vector<sight> osights;
+  if (m_engine == vision_engine::angular_sweep)
+  {
+    _sweep(get_source(), m_sights, _scratch(), m_incremental);
+    return;
+  }
+
+  // target sights refer to m_sights for their geometry
+  vision_scratch &scratch = _scratch();
+  vision_vector<compact_sight> &tsights = scratch.tsights;
+  vision_vector<compact_sight> &nsights = scratch.nsights;
+  vision_vector<compact_sight> &osights = scratch.osights;
+  _compact_sights(m_sights, tsights);
+  nsights.clear();
+  osights.clear();
 
   nsights.reserve(m_sights.size());
   osights.reserve(m_sights.size() * 2);
@@ -676,7 +1450,8 @@ mw::vision_processor::process()
     nsights.clear();
   }
 
-  m_sights = std::move(osights);
+  _expand_sights(osights, scratch.sights);
+  std::swap(m_sights, scratch.sights);
 }
 
 void
@@ -697,8 +1472,8 @@ mw::vision_processor::apply(bool foreignsource, sight_container &tgtsights)
           const circle &circ = s.static_data.circle;
           const pt2d_d a = circ(s.sight_data.circle.cphi1);
           const pt2d_d b = circ(s.sight_data.circle.cphi2);
-          s.phi1 = dirangle(a - source.center);
-          s.phi2 = dirangle(b - source.center);
+          s.phi1 = sight_angle(a - source.center);
+          s.phi2 = sight_angle(b - source.center);
           // XXX cheating
           if (interval_size({s.phi1, s.phi2}) > M_PI)
           {
@@ -712,8 +1487,8 @@ mw::vision_processor::apply(bool foreignsource, sight_container &tgtsights)
           const line_segment &line = s.static_data.line;
           const pt2d_d a = line(s.sight_data.line.t1);
           const pt2d_d b = line(s.sight_data.line.t2);
-          s.phi1 = dirangle(a - source.center);
-          s.phi2 = dirangle(b - source.center);
+          s.phi1 = sight_angle(a - source.center);
+          s.phi2 = sight_angle(b - source.center);
           // XXX cheating
           if (interval_size({s.phi1, s.phi2}) > M_PI)
           {
@@ -726,9 +1501,14 @@ mw::vision_processor::apply(bool foreignsource, sight_container &tgtsights)
     }
   }
 
-  std::vector<sight> tsights {tgtsights.begin(), tgtsights.end()};
-  std::vector<sight> nsights;
-  std::vector<sight> osights;
+  // target sights refer to tgtsights for their geometry
+  vision_scratch &scratch = _scratch();
+  vision_vector<compact_sight> &tsights = scratch.tsights;
+  vision_vector<compact_sight> &nsights = scratch.nsights;
+  vision_vector<compact_sight> &osights = scratch.osights;
+  _compact_sights(tgtsights, tsights);
+  nsights.clear();
+  osights.clear();
 
   nsights.reserve(tsights.size());
   osights.reserve(tsights.size() * 2);
@@ -749,7 +1529,8 @@ mw::vision_processor::apply(bool foreignsource, sight_container &tgtsights)
     nsights.clear();
   }
 
-  tgtsights = std::move(osights);
+  _expand_sights(osights, scratch.sights);
+  std::swap(tgtsights, scratch.sights);
 }
 
 void
@@ -765,7 +1546,9 @@ mw::vision_processor::shadowcast(SDL_Renderer *rend, const rectangle &box,
   SDL_BlendMode oldblendmode;
   SDL_GetRenderDrawBlendMode(rend, &oldblendmode);
   SDL_SetRenderDrawBlendMode(rend, blendmode);
-  std::vector<pt2d_d> pts;
+  vision_vector<pt2d_d> &pts = _scratch().points;
+  shadow_mesh &mesh = _scratch().shadows;
+  mesh.clear();
   for (const sight &s : m_sights)
   {
     // FIXME XXX causing vision bug with bullet glow being visible when it shouldnt
@@ -802,14 +1585,9 @@ mw::vision_processor::shadowcast(SDL_Renderer *rend, const rectangle &box,
     pts.clear();
     cast_shadows_on_the_box(source.center, line, t1, t2, s.phi1, s.phi2, box,
         boxinfo, pts);
-    if (pts.empty())
-      continue;
-
-    int16_t xs[pts.size()], ys[pts.size()];
-    for (size_t i = 0; i < pts.size(); ++i)
-      std::tie(xs[i], ys[i]) = pt2d<int16_t>(world_to_target(pts[i]));
-    filledPolygonColor(rend, xs, ys, pts.size(), color);
+    mesh.add_polygon(pts, world_to_target, color);
   }
+  mesh.render(rend);
   SDL_SetRenderDrawBlendMode(rend, oldblendmode);
 }
 
@@ -0,0 +1,94 @@
+#include "vision_cache.hpp"
+#include "area_map.hpp"
+
+#include <algorithm>
+
+
+static bool
+_same_sights(const mw::vision_processor::sight_container &a,
+    const mw::vision_processor::const_sights_view &b)
+{
+  using namespace mw;
+
+  const auto same = [] (const sight &x, const sight &y) {
+    if (not same_identity(x, y) or x.tag != y.tag or
+        x.is_transparent != y.is_transparent or
+        x.phi1 != y.phi1 or x.phi2 != y.phi2)
+      return false;
+    switch (x.tag)
+    {
+      case sight::line:
+        return x.sight_data.line.t1 == y.sight_data.line.t1
+           and x.sight_data.line.t2 == y.sight_data.line.t2;
+      case sight::circle:
+        return x.sight_data.circle.cphi1 == y.sight_data.circle.cphi1
+           and x.sight_data.circle.cphi2 == y.sight_data.circle.cphi2;
+    }
+    return false;
+  };
+  return std::equal(a.begin(), a.end(), b.begin(), b.end(), same);
+}
+
+const mw::vision_processor&
+mw::vision_cache::update(const area_map &map, const circle &source,
+    const vis_obstacle *ignore)
+{
+  const bool moved =
+    not m_valid or
+    source.radius != m_source.radius or
+    ignore != m_ignore or
+    mag2(source.center - m_source.center) > m_epsilon*m_epsilon;
+  if (moved)
+  {
+    m_source = source;
+    m_ignore = ignore;
+  }
+
+  vis_obstacle_list &obstacles = m_obstacles;
+  map.collect_vis_obstacles(m_source, obstacles);
+  const auto mutables_begin = std::stable_partition(obstacles.begin(),
+      obstacles.end(), [] (const vis_obstacle *obs) {
+    return obs->is_immutable();
+  });
+
+  // visible parts of immutable obstacles
+  const bool immutables_changed = moved or not std::equal(obstacles.begin(),
+      mutables_begin, m_immutables.begin(), m_immutables.end());
+  if (immutables_changed)
+  {
+    vision_processor &visproc = m_immutables_vision;
+    visproc.reset();
+    visproc.set_source(m_source);
+    visproc.set_ignore(m_ignore);
+    visproc.load_obstacles(obstacles.begin(), mutables_begin);
+    visproc.process();
+    m_immutable_sights.assign(visproc.get_sights().begin(),
+        visproc.get_sights().end());
+    m_immutables.assign(obstacles.begin(), mutables_begin);
+  }
+
+  // other obstacles are cheap to cast sights on, but may change any time
+  vision_processor &mutables = m_mutables_vision;
+  mutables.reset();
+  mutables.set_source(m_source);
+  mutables.set_ignore(m_ignore);
+  mutables.load_obstacles(mutables_begin, obstacles.end());
+  const vision_processor &cmutables = mutables;
+  const bool mutables_changed =
+    not _same_sights(m_mutable_sights, cmutables.get_sights());
+
+  if (immutables_changed or mutables_changed)
+  {
+    m_mutable_sights.assign(cmutables.get_sights().begin(),
+        cmutables.get_sights().end());
+    m_vision.reset();
+    m_vision.set_source(m_source);
+    m_vision.set_ignore(m_ignore);
+    m_vision.load_sights(m_immutable_sights);
+    m_vision.load_sights(m_mutable_sights);
+    m_vision.process();
+  }
+
+  m_valid = true;
+  return m_vision;
+}
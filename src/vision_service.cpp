@@ -0,0 +1,26 @@
+#include "vision_service.hpp"
+#include "area_map.hpp"
+
+
+void
+mw::vision_service::run(const area_map &map)
+{
+  const auto process_chunk = [&] (size_t, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i)
+    {
+      const request_type &req = m_requests[i];
+      vision_processor &visproc = *req.target;
+      visproc.reset();
+      visproc.set_source(req.source);
+      visproc.set_ignore(req.ignore);
+      visproc.load_obstacles(map);
+      visproc.process();
+    }
+  };
+
+  if (m_pool)
+    m_pool->for_each_chunk(m_requests.size(), process_chunk);
+  else
+    process_chunk(0, 0, m_requests.size());
+  m_requests.clear();
+}